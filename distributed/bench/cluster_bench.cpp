@@ -0,0 +1,407 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+
+#include <grpcpp/grpcpp.h>
+#include "coordinator_service.h"
+#include "storage_service.h"
+#include "channel_pool.h"
+#include "partitioner.h"
+#include "workload.h"
+
+/**
+ * In-process cluster benchmark.
+ *
+ * Hosts a coordinator and N storage nodes in one process, connected by
+ * gRPC in-process channels (same services and serialization as a real
+ * cluster, no sockets), loads one column and replays a src/workload.h
+ * workload through the coordinator from several client threads. Repeating
+ * this for several node counts shows how throughput and latency scale.
+ *
+ * The workload may be a query trace (trace:FILE, src/query_trace.h); its
+ * queries are replayed back to back, or at --speed times their recorded
+ * pace. Its updates are skipped, since counts are checked against the
+ * loaded data.
+ */
+
+using grpc::Server;
+using grpc::ServerBuilder;
+
+using namespace crackstore;
+
+
+
+class InProcessCluster {
+public:
+    InProcessCluster(int num_nodes, std::chrono::microseconds coalesce_window, const std::string& engine) {
+        ChannelOptions options;
+
+        coordinator_ = std::make_unique<CoordinatorServiceImpl>(coalesce_window, options);
+        coordinator_->set_query_logging(false);
+        coordinator_server_ = StartServer(coordinator_.get(), options);
+        coordinator_stub_ = CoordinatorService::NewStub(
+            coordinator_server_->InProcessChannel(MakeChannelArguments(options)));
+
+        for (int i = 0; i < num_nodes; ++i) {
+            auto node = std::make_unique<StorageServiceImpl>("node-" + std::to_string(i + 1), engine);
+            node->set_query_logging(false);
+            auto server = StartServer(node.get(), options);
+            auto channel = server->InProcessChannel(MakeChannelArguments(options));
+
+            node_ids_.push_back(coordinator_->RegisterLocalNode("inprocess", i + 1, channel));
+            node_stubs_.push_back(StorageService::NewStub(channel));
+            nodes_.push_back(std::move(node));
+            node_servers_.push_back(std::move(server));
+        }
+    }
+
+    ~InProcessCluster() {
+        coordinator_server_->Shutdown();
+        for (auto& server : node_servers_) {
+            server->Shutdown();
+        }
+    }
+
+    // Equi-depth range partitioning across the nodes, as the client does
+    bool Load(const std::string& column_name, const std::vector<int>& data) {
+        int num_nodes = static_cast<int>(nodes_.size());
+        PartitionPlan plan = plan_partitions(data.data(), data.size(), num_nodes);
+        std::vector<std::vector<int>> partitions = split_by_partition(data.data(), data.size(), plan, 0);
+
+        std::vector<std::thread> loaders;
+        std::atomic<int> failures{0};
+        for (int i = 0; i < num_nodes; ++i) {
+            loaders.emplace_back([&, i]() {
+                LoadColumnRequest request;
+                request.set_column_name(column_name);
+                request.mutable_data()->Add(partitions[i].begin(), partitions[i].end());
+
+                LoadColumnResponse response;
+                ClientContext context;
+                Status status = node_stubs_[i]->LoadColumn(&context, request, &response);
+                if (!status.ok() || !response.success()) {
+                    std::cerr << "[ClusterBench] Load failed on " << node_ids_[i] << ": "
+                              << status.error_message() << "\n";
+                    failures++;
+                }
+            });
+        }
+        for (auto& loader : loaders) loader.join();
+        if (failures > 0) return false;
+
+        PartitionMap partition_map;
+        partition_map.set_column_name(column_name);
+        partition_map.mutable_splitters()->Add(plan.splitters.begin(), plan.splitters.end());
+        partition_map.mutable_node_ids()->Add(node_ids_.begin(), node_ids_.end());
+
+        StatusResponse response;
+        ClientContext context;
+        Status status = coordinator_stub_->SetPartitionMap(&context, partition_map, &response);
+        return status.ok() && response.success();
+    }
+
+    // Push every node's crack summary to the coordinator, as a heartbeat would
+    void SendHeartbeats() {
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            HeartbeatRequest request;
+            request.set_node_id(node_ids_[i]);
+            nodes_[i]->FillColumnSummaries(&request, kSummaryBoundaries);
+
+            HeartbeatResponse response;
+            ClientContext context;
+            coordinator_stub_->Heartbeat(&context, request, &response);
+        }
+    }
+
+    CoordinatorService::Stub* coordinator() { return coordinator_stub_.get(); }
+
+private:
+    static std::unique_ptr<Server> StartServer(grpc::Service* service, const ChannelOptions& options) {
+        ServerBuilder builder;
+        ConfigureServerBuilder(builder, options);
+        builder.RegisterService(service);
+        return builder.BuildAndStart();
+    }
+
+    std::unique_ptr<CoordinatorServiceImpl> coordinator_;
+    std::unique_ptr<Server> coordinator_server_;
+    std::unique_ptr<CoordinatorService::Stub> coordinator_stub_;
+
+    std::vector<std::unique_ptr<StorageServiceImpl>> nodes_;
+    std::vector<std::unique_ptr<Server>> node_servers_;
+    std::vector<std::unique_ptr<StorageService::Stub>> node_stubs_;
+    std::vector<std::string> node_ids_;
+};
+
+
+struct RunResult {
+    int nodes = 0;
+    double load_s = 0.0;
+    double elapsed_s = 0.0;
+    int queries = 0;
+    int mismatches = 0;
+    int failures = 0;
+    long long tuples_touched = 0;
+    long long nodes_queried = 0;
+    std::vector<double> latencies_ms;
+
+    double percentile(double p) const {
+        if (latencies_ms.empty()) return 0.0;
+        size_t index = std::min(latencies_ms.size() - 1, static_cast<size_t>(p * latencies_ms.size()));
+        return latencies_ms[index];
+    }
+};
+
+
+RunResult run_cluster(int num_nodes, const std::vector<int>& data,
+                      const std::vector<std::pair<int, int>>& queries,
+                      const std::vector<double>& issued_at, double speed,
+                      const std::vector<int>& expected, int clients,
+                      std::chrono::microseconds coalesce_window, const std::string& engine) {
+    const std::string column = "bench";
+    RunResult result;
+    result.nodes = num_nodes;
+
+    InProcessCluster cluster(num_nodes, coalesce_window, engine);
+
+    auto load_start = std::chrono::steady_clock::now();
+    if (!cluster.Load(column, data)) {
+        result.failures = static_cast<int>(queries.size());
+        return result;
+    }
+    result.load_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+    cluster.SendHeartbeats();
+
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<size_t> next{0};
+    std::atomic<int> mismatches{0};
+    std::atomic<int> failures{0};
+    std::atomic<long long> touched{0};
+    std::atomic<long long> nodes_queried{0};
+
+    auto run_start = std::chrono::steady_clock::now();
+    auto client = [&](int c) {
+        for (size_t q = next++; q < queries.size(); q = next++) {
+            if (speed > 0.0) {
+                std::this_thread::sleep_until(run_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(issued_at[q] / speed)));
+            }
+            DistributedRangeQueryRequest request;
+            request.set_column_name(column);
+            request.set_low(queries[q].first);
+            request.set_high(queries[q].second);
+
+            DistributedRangeQueryResponse response;
+            ClientContext context;
+
+            auto start = std::chrono::steady_clock::now();
+            Status status = cluster.coordinator()->RangeQuery(&context, request, &response);
+            auto end = std::chrono::steady_clock::now();
+
+            if (!status.ok() || !response.success()) {
+                failures++;
+                continue;
+            }
+            if (response.total_count() != expected[q]) {
+                mismatches++;
+            }
+            nodes_queried += response.nodes_queried();
+            for (const auto& node_result : response.node_results()) {
+                touched += node_result.stats().tuples_touched();
+            }
+            latencies[c].push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    };
+
+    auto start = run_start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) threads.emplace_back(client, c);
+    for (auto& t : threads) t.join();
+    result.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& l : latencies) {
+        result.latencies_ms.insert(result.latencies_ms.end(), l.begin(), l.end());
+    }
+    std::sort(result.latencies_ms.begin(), result.latencies_ms.end());
+    result.queries = static_cast<int>(queries.size());
+    result.mismatches = mismatches;
+    result.failures = failures;
+    result.tuples_touched = touched;
+    result.nodes_queried = nodes_queried;
+
+    return result;
+}
+
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "Options:\n"
+              << "  --nodes LIST           Comma-separated node counts (default: 1,2,4)\n"
+              << "  --rows N               Generate N rows like gen_data (default: 10000000)\n"
+              << "  --data FILE            Load a binary int file instead of generating rows\n"
+              << "  --queries Q            Queries per run (default: 1000)\n"
+              << "  --workload NAME        src/workload.h workload, or trace:FILE (default: Random)\n"
+              << "  --speed X              Replay a trace at X times its recorded pace (default: 0,\n"
+              << "                         back to back)\n"
+              << "  --selectivity S        Query width as a fraction of the max value (default: 0.01)\n"
+              << "  --clients C            Concurrent client threads (default: 4)\n"
+              << "  --coalesce-window-us US\n"
+              << "                         Coordinator coalescing window (default: 0)\n"
+              << "  --engine KIND          Storage node column engine: crack, tuned or hybrid (default: crack)\n"
+              << "  --help                 Show this help\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> node_counts = {1, 2, 4};
+    int rows = 10000000;
+    std::string data_file;
+    int num_queries = 1000;
+    std::string workload = "Random";
+    double selectivity = 0.01;
+    int clients = 4;
+    int coalesce_window_us = 0;
+    double speed = 0.0;
+    std::string engine = "crack";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--nodes" && i + 1 < argc) {
+            node_counts.clear();
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                node_counts.push_back(std::stoi(item));
+            }
+        } else if (arg == "--rows" && i + 1 < argc) {
+            rows = std::stoi(argv[++i]);
+        } else if (arg == "--data" && i + 1 < argc) {
+            data_file = argv[++i];
+        } else if (arg == "--queries" && i + 1 < argc) {
+            num_queries = std::stoi(argv[++i]);
+        } else if (arg == "--workload" && i + 1 < argc) {
+            workload = argv[++i];
+        } else if (arg == "--selectivity" && i + 1 < argc) {
+            selectivity = std::stod(argv[++i]);
+        } else if (arg == "--speed" && i + 1 < argc) {
+            speed = std::stod(argv[++i]);
+        } else if (arg == "--clients" && i + 1 < argc) {
+            clients = std::stoi(argv[++i]);
+        } else if (arg == "--coalesce-window-us" && i + 1 < argc) {
+            coalesce_window_us = std::stoi(argv[++i]);
+        } else if (arg == "--engine" && i + 1 < argc) {
+            engine = argv[++i];
+            if (!is_column_engine(engine)) {
+                std::cerr << "Unknown engine: " << engine << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Same generator and seed as src/gen_data.cpp, so --rows N matches N.data
+    std::vector<int> data;
+    if (data_file.empty()) {
+        data.resize(rows);
+        Random r(140384);
+        for (int i = 0; i < rows; ++i) data[i] = abs(r.nextInt());
+    } else {
+        std::ifstream in(data_file, std::ios::binary | std::ios::ate);
+        if (!in) {
+            std::cerr << "[ClusterBench] Cannot open " << data_file << "\n";
+            return 1;
+        }
+        data.resize(in.tellg() / sizeof(int));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(int));
+    }
+    if (data.empty()) {
+        std::cerr << "[ClusterBench] No data\n";
+        return 1;
+    }
+
+    // Queries are generated once so every node count replays the same ones
+    int max_value = *std::max_element(data.begin(), data.end());
+    std::vector<char> workload_name(workload.begin(), workload.end());
+    workload_name.push_back('\0');
+    Workload W(max_value, workload_name.data(), static_cast<int>(selectivity * max_value));
+
+    std::vector<std::pair<int, int>> queries;
+    std::vector<double> issued_at;
+    long long skipped_updates = 0;
+    for (int q = 0; q < num_queries; ++q) {
+        int a, b, nu;
+        if (!W.query(a, b)) break;
+        queries.emplace_back(a, b);
+        issued_at.push_back(W.issued_at());
+        W.updates(nu);
+        skipped_updates += nu;
+    }
+    if (skipped_updates > 0) {
+        std::cout << "[ClusterBench] Skipping the trace's " << skipped_updates << " updates\n";
+    }
+
+    std::vector<int> sorted(data);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<int> expected;
+    for (const auto& [a, b] : queries) {
+        expected.push_back(static_cast<int>(
+            std::lower_bound(sorted.begin(), sorted.end(), b) -
+            std::lower_bound(sorted.begin(), sorted.end(), a)));
+    }
+    sorted.clear();
+    sorted.shrink_to_fit();
+
+    std::cout << "[ClusterBench] " << data.size() << " rows, " << queries.size() << " "
+              << workload << " queries, " << clients << " clients, " << engine << " engine\n";
+
+    std::vector<RunResult> results;
+    for (int n : node_counts) {
+        results.push_back(run_cluster(n, data, queries, issued_at, speed, expected, clients,
+                                      std::chrono::microseconds(coalesce_window_us), engine));
+    }
+
+    std::cout << "\n=== Scaling ===\n"
+              << std::setw(6) << "nodes" << std::setw(10) << "load_s" << std::setw(10) << "qps"
+              << std::setw(10) << "p50_ms" << std::setw(10) << "p95_ms" << std::setw(10) << "p99_ms"
+              << std::setw(14) << "touched/q" << std::setw(9) << "nodes/q" << std::setw(9) << "speedup" << "\n";
+
+    bool ok = true;
+    double base_qps = 0.0;
+    for (const RunResult& r : results) {
+        double qps = r.elapsed_s > 0.0 ? r.queries / r.elapsed_s : 0.0;
+        if (base_qps == 0.0) base_qps = qps;
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(6) << r.nodes << std::setw(10) << r.load_s
+                  << std::setw(10) << std::setprecision(1) << qps << std::setprecision(3)
+                  << std::setw(10) << r.percentile(0.50) << std::setw(10) << r.percentile(0.95)
+                  << std::setw(10) << r.percentile(0.99)
+                  << std::setw(14) << (r.queries > 0 ? r.tuples_touched / r.queries : 0)
+                  << std::setw(9) << (r.queries > 0 ? static_cast<double>(r.nodes_queried) / r.queries : 0.0)
+                  << std::setw(8) << std::setprecision(2) << (base_qps > 0.0 ? qps / base_qps : 0.0) << "x";
+        if (r.mismatches > 0 || r.failures > 0) {
+            std::cout << "  (" << r.mismatches << " wrong counts, " << r.failures << " failed)";
+            ok = false;
+        }
+        std::cout << "\n";
+    }
+    std::cout << "\n";
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+#include "async_client.h"
+
+#include "tracing.h"
+
+namespace crackstore {
+
+struct AsyncCrackStoreClient::QueryCall : Call {
+    DistributedRangeQueryRequest request;
+    DistributedRangeQueryResponse response;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<DistributedRangeQueryResponse>> reader;
+    std::unique_ptr<Span> span;
+    RangeQueryCallback callback;
+
+    void Start(CoordinatorService::Stub* stub, grpc::CompletionQueue* cq) override {
+        reader = stub->PrepareAsyncRangeQuery(&context, request, cq);
+        reader->StartCall();
+        reader->Finish(&response, &status, this);
+    }
+
+    void Complete() override {
+        span->set_arg("count", response.total_count());
+        span->end();
+
+        RangeQueryResult result;
+        result.status = std::move(status);
+        result.response = std::move(response);
+        result.latency_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - submitted).count();
+        callback(std::move(result));
+    }
+};
+
+struct AsyncCrackStoreClient::UpdateCall : Call {
+    UpdateRequest request;
+    UpdateResponse response;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<UpdateResponse>> reader;
+    UpdateCallback callback;
+
+    void Start(CoordinatorService::Stub* stub, grpc::CompletionQueue* cq) override {
+        reader = stub->PrepareAsyncUpdate(&context, request, cq);
+        reader->StartCall();
+        reader->Finish(&response, &status, this);
+    }
+
+    void Complete() override {
+        UpdateResult result;
+        result.status = std::move(status);
+        result.response = std::move(response);
+        callback(std::move(result));
+    }
+};
+
+
+AsyncCrackStoreClient::AsyncCrackStoreClient(const std::string& coordinator_address,
+                                             const AsyncClientOptions& options)
+    : options_(options) {
+    if (options_.channel.subchannels < 1) options_.channel.subchannels = 1;
+    if (options_.max_in_flight_per_connection < 1) options_.max_in_flight_per_connection = 1;
+    if (options_.completion_threads < 1) options_.completion_threads = 1;
+
+    // Unpooled channels with distinct indexes: one TCP connection each, so
+    // the in-flight limit really is per connection
+    for (int i = 0; i < options_.channel.subchannels; ++i) {
+        Connection connection;
+        connection.stub = CoordinatorService::NewStub(
+            ChannelPool::CreateUnpooled(coordinator_address, options_.channel, i));
+        connections_.push_back(std::move(connection));
+    }
+    for (int i = 0; i < options_.completion_threads; ++i) {
+        completion_threads_.emplace_back(&AsyncCrackStoreClient::CompletionLoop, this);
+    }
+}
+
+AsyncCrackStoreClient::~AsyncCrackStoreClient() {
+    Drain();
+    cq_.Shutdown();
+    for (auto& thread : completion_threads_) thread.join();
+}
+
+
+void AsyncCrackStoreClient::RangeQuery(const std::string& column, int low, int high,
+                                       RangeQueryCallback callback) {
+    auto call = std::make_unique<QueryCall>();
+    call->request.set_column_name(column);
+    call->request.set_low(low);
+    call->request.set_high(high);
+    call->callback = std::move(callback);
+
+    call->span = std::make_unique<Span>("client.AsyncRangeQuery", TraceContext());
+    call->span->set_arg("low", low);
+    call->span->set_arg("high", high);
+    inject_trace_context(call->context, call->span->context());
+
+    Submit(std::move(call));
+}
+
+std::future<RangeQueryResult> AsyncCrackStoreClient::RangeQuery(const std::string& column, int low, int high) {
+    auto promise = std::make_shared<std::promise<RangeQueryResult>>();
+    RangeQuery(column, low, high, [promise](RangeQueryResult&& result) {
+        promise->set_value(std::move(result));
+    });
+    return promise->get_future();
+}
+
+void AsyncCrackStoreClient::BatchRangeQuery(const std::string& column,
+                                            const std::vector<std::pair<int, int>>& ranges,
+                                            BatchQueryCallback callback) {
+    if (ranges.empty()) {
+        callback({});
+        return;
+    }
+
+    struct Batch {
+        std::vector<RangeQueryResult> results;
+        std::atomic<size_t> remaining;
+        BatchQueryCallback callback;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->results.resize(ranges.size());
+    batch->remaining = ranges.size();
+    batch->callback = std::move(callback);
+
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        RangeQuery(column, ranges[i].first, ranges[i].second, [batch, i](RangeQueryResult&& result) {
+            batch->results[i] = std::move(result);
+            if (batch->remaining.fetch_sub(1) == 1) {
+                batch->callback(std::move(batch->results));
+            }
+        });
+    }
+}
+
+std::future<std::vector<RangeQueryResult>> AsyncCrackStoreClient::BatchRangeQuery(
+    const std::string& column, const std::vector<std::pair<int, int>>& ranges) {
+    auto promise = std::make_shared<std::promise<std::vector<RangeQueryResult>>>();
+    BatchRangeQuery(column, ranges, [promise](std::vector<RangeQueryResult>&& results) {
+        promise->set_value(std::move(results));
+    });
+    return promise->get_future();
+}
+
+void AsyncCrackStoreClient::Update(const UpdateRequest& request, UpdateCallback callback) {
+    auto call = std::make_unique<UpdateCall>();
+    call->request = request;
+    call->callback = std::move(callback);
+    Submit(std::move(call));
+}
+
+std::future<UpdateResult> AsyncCrackStoreClient::Update(const UpdateRequest& request) {
+    auto promise = std::make_shared<std::promise<UpdateResult>>();
+    Update(request, [promise](UpdateResult&& result) {
+        promise->set_value(std::move(result));
+    });
+    return promise->get_future();
+}
+
+
+void AsyncCrackStoreClient::Drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+size_t AsyncCrackStoreClient::queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiting_.size();
+}
+
+
+void AsyncCrackStoreClient::Submit(std::unique_ptr<Call> call) {
+    call->submitted = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    outstanding_++;
+
+    // Least-loaded connection with a free slot, else wait in FIFO order
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(connections_.size()); ++i) {
+        if (connections_[i].in_flight >= options_.max_in_flight_per_connection) continue;
+        if (best < 0 || connections_[i].in_flight < connections_[best].in_flight) best = i;
+    }
+    if (best < 0 || !waiting_.empty()) {
+        waiting_.push_back(std::move(call));
+        return;
+    }
+    StartLocked(std::move(call), best);
+}
+
+// Caller must hold mutex_
+void AsyncCrackStoreClient::StartLocked(std::unique_ptr<Call> call, int connection) {
+    // The deadline covers the RPC itself, not time spent waiting for a slot
+    call->context.set_deadline(std::chrono::system_clock::now() + options_.timeout);
+    call->connection = connection;
+    connections_[connection].in_flight++;
+    in_flight_total_++;
+
+    // Released in CompletionLoop when the completion queue hands it back
+    Call* raw = call.release();
+    raw->Start(connections_[connection].stub.get(), &cq_);
+}
+
+void AsyncCrackStoreClient::CompletionLoop() {
+    void* tag;
+    bool ok;
+    while (cq_.Next(&tag, &ok)) {
+        std::unique_ptr<Call> call(static_cast<Call*>(tag));
+        call->Complete();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_[call->connection].in_flight--;
+        in_flight_total_--;
+        if (!waiting_.empty()) {
+            std::unique_ptr<Call> next = std::move(waiting_.front());
+            waiting_.pop_front();
+            StartLocked(std::move(next), call->connection);
+        }
+        if (--outstanding_ == 0) {
+            drained_.notify_all();
+        }
+    }
+}
+
+}
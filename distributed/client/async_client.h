@@ -0,0 +1,136 @@
+#ifndef ASYNC_CLIENT_H
+#define ASYNC_CLIENT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+#include "crackstore.grpc.pb.h"
+#include "channel_pool.h"
+
+/**
+ * Asynchronous, pipelined CrackStore client for embedding in servers.
+ *
+ * Calls return immediately and complete on a small pool of completion
+ * threads, so an application can keep thousands of queries outstanding
+ * without a thread per query. Each connection carries at most
+ * `max_in_flight_per_connection` RPCs; calls beyond the cluster-wide limit
+ * wait in a FIFO and are started as earlier ones finish.
+ *
+ * Callbacks run on a completion thread and must not block on other calls
+ * of the same client (e.g. wait on a future); issuing new calls from a
+ * callback is fine.
+ */
+
+namespace crackstore {
+
+struct AsyncClientOptions {
+    ChannelOptions channel;                             // subchannels = connections to the coordinator
+    int max_in_flight_per_connection = 64;
+    int completion_threads = 1;
+    std::chrono::milliseconds timeout{30000};           // Per-call deadline
+};
+
+struct RangeQueryResult {
+    grpc::Status status;
+    DistributedRangeQueryResponse response;
+    double latency_ms = 0.0;                            // Includes time queued behind the in-flight limit
+
+    bool ok() const { return status.ok() && response.success(); }
+};
+
+struct UpdateResult {
+    grpc::Status status;
+    UpdateResponse response;
+
+    bool ok() const { return status.ok() && response.success(); }
+};
+
+using RangeQueryCallback = std::function<void(RangeQueryResult&&)>;
+using BatchQueryCallback = std::function<void(std::vector<RangeQueryResult>&&)>;
+using UpdateCallback = std::function<void(UpdateResult&&)>;
+
+
+class AsyncCrackStoreClient {
+public:
+    explicit AsyncCrackStoreClient(const std::string& coordinator_address,
+                                   const AsyncClientOptions& options = AsyncClientOptions());
+
+    // Waits for outstanding calls, then stops the completion threads
+    ~AsyncCrackStoreClient();
+
+    AsyncCrackStoreClient(const AsyncCrackStoreClient&) = delete;
+    AsyncCrackStoreClient& operator=(const AsyncCrackStoreClient&) = delete;
+
+    // Count rows of `column` in [low, high)
+    void RangeQuery(const std::string& column, int low, int high, RangeQueryCallback callback);
+    std::future<RangeQueryResult> RangeQuery(const std::string& column, int low, int high);
+
+    /**
+     * Several ranges of one column, pipelined. Results arrive together, in
+     * request order; queries that reach the coordinator at the same time
+     * can share a coalesced batch there.
+     */
+    void BatchRangeQuery(const std::string& column, const std::vector<std::pair<int, int>>& ranges,
+                         BatchQueryCallback callback);
+    std::future<std::vector<RangeQueryResult>> BatchRangeQuery(
+        const std::string& column, const std::vector<std::pair<int, int>>& ranges);
+
+    void Update(const UpdateRequest& request, UpdateCallback callback);
+    std::future<UpdateResult> Update(const UpdateRequest& request);
+
+    // Block until every call issued so far has completed
+    void Drain();
+
+    int in_flight() const { return in_flight_total_.load(); }    // Started, not yet completed
+    size_t queued() const;                                        // Waiting for an in-flight slot
+
+private:
+    // One outstanding RPC; owned by the completion queue until it finishes
+    struct Call {
+        virtual ~Call() = default;
+        virtual void Start(CoordinatorService::Stub* stub, grpc::CompletionQueue* cq) = 0;
+        virtual void Complete() = 0;
+
+        grpc::ClientContext context;
+        grpc::Status status;
+        std::chrono::steady_clock::time_point submitted;
+        int connection = -1;
+    };
+    struct QueryCall;
+    struct UpdateCall;
+
+    struct Connection {
+        std::unique_ptr<CoordinatorService::Stub> stub;
+        int in_flight = 0;
+    };
+
+    void Submit(std::unique_ptr<Call> call);
+    void StartLocked(std::unique_ptr<Call> call, int connection);
+    void CompletionLoop();
+
+    AsyncClientOptions options_;
+    grpc::CompletionQueue cq_;
+    std::vector<std::thread> completion_threads_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable drained_;
+    std::vector<Connection> connections_;
+    std::deque<std::unique_ptr<Call>> waiting_;
+    std::atomic<int> in_flight_total_{0};
+    long long outstanding_ = 0;                           // In flight + waiting
+};
+
+}
+
+#endif
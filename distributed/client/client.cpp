@@ -4,9 +4,25 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <climits>
+#include <iomanip>
 
 #include <grpcpp/grpcpp.h>
 #include "crackstore.grpc.pb.h"
+#include "tracing.h"
+#include "channel_pool.h"
+#include "partitioner.h"
+#include "histogram.h"
+#include "async_client.h"
+#include "bounded_queue.h"
+#include "mapped_file.h"
+#include "workload.h"
+#include "metrics.h"
 
 using grpc::Channel;
 using grpc::ClientContext;
@@ -15,13 +31,33 @@ using grpc::Status;
 using namespace crackstore;
 
 
+// Streamed loads: rows per chunk message, chunks buffered per node, and
+// threads routing rows to nodes
+constexpr size_t kLoadChunkRows = 1 << 16;
+constexpr size_t kLoadQueueDepth = 4;
+constexpr unsigned kMaxLoadScanners = 8;
+
+
+struct LoadGenOptions {
+    int concurrency = 4;                // Client threads (in-flight requests)
+    double target_qps = 0.0;            // 0 = closed loop: each thread sends back to back
+    double warmup_s = 5.0;              // Run but don't record
+    double duration_s = 30.0;           // Recorded phase
+    std::string workload = "Random";    // src/workload.h workload name
+    double selectivity = 0.01;          // Query width as a fraction of the domain
+    int domain = INT_MAX - 1;           // Queries fall in [0, domain]
+    double update_ratio = 0.0;          // Fraction of operations that are updates
+    std::string hdr_file;               // Percentile distributions in .hgrm format
+};
+
+
 
 class CrackStoreClient {
 public:
-    CrackStoreClient(const std::string& coordinator_address) 
-        : coordinator_address_(coordinator_address) {
-        auto channel = grpc::CreateChannel(coordinator_address, grpc::InsecureChannelCredentials());
-        coordinator_stub_ = CoordinatorService::NewStub(channel);
+    CrackStoreClient(const std::string& coordinator_address,
+                     const ChannelOptions& channel_options = ChannelOptions()) 
+        : coordinator_address_(coordinator_address), channel_pool_(channel_options) {
+        coordinator_stub_ = channel_pool_.NewStub<CoordinatorService>(coordinator_address);
     }
 
     
@@ -49,6 +85,17 @@ public:
         }
         std::cout << "\n";
 
+        if (response.has_coalescing()) {
+            const auto& coalescing = response.coalescing();
+            std::cout << "Query coalescing:\n"
+                      << "  Queries received: " << coalescing.queries_received() << "\n"
+                      << "  Batches dispatched: " << coalescing.batches_dispatched()
+                      << " (" << coalescing.ranges_dispatched() << " distinct ranges)\n"
+                      << "  Coalescing ratio: " << coalescing.coalescing_ratio() << "\n"
+                      << "  Queue time: avg=" << coalescing.avg_queue_time_ms()
+                      << "ms, max=" << coalescing.max_queue_time_ms() << "ms\n\n";
+        }
+
         return true;
     }
 
@@ -59,26 +106,31 @@ public:
         
         std::cout << "Loading column '" << column_name << "' from " << file_path << "\n";
 
-        // Read binary file
-        std::ifstream file(file_path, std::ios::binary | std::ios::ate);
-        if (! file) {
+        // Mapped rather than read, so the file is never held in memory twice
+        MappedFile file;
+        if (!file.open(file_path)) {
             std::cerr << "Failed to open file: " << file_path << "\n";
             return false;
         }
+        size_t num_elements = file.size() / sizeof(int);
+        std::cout << "Mapped " << num_elements << " integers from file\n";
 
-        std::streamsize size = file.tellg();
-        file. seekg(0, std::ios::beg);
-
-        int num_elements = size / sizeof(int);
-        std::vector<int> data(num_elements);
-
-        if (! file.read(reinterpret_cast<char*>(data.data()), size)) {
-            std::cerr << "Failed to read file\n";
-            return false;
-        }
-
-        std::cout << "Read " << num_elements << " integers from file\n";
+        return LoadColumn(column_name, static_cast<const int*>(file.data()), num_elements, num_partitions);
+    }
 
+    /**
+     * Range-partition rows across the healthy nodes and register the
+     * partition map with the coordinator.
+     *
+     * Every node gets its own LoadColumnStream, all running at once, so the
+     * load takes about as long as the slowest node. Scanner threads route
+     * rows into per-node chunks and hand them to the node's sender through
+     * a bounded queue, which caps client memory at a few chunks per node
+     * regardless of the column size.
+     */
+    bool LoadColumn(const std::string& column_name, const int* data, size_t n,
+                    int num_partitions = 0, bool verbose = true) {
+        
         // Get node list from coordinator
         ClusterStatusRequest status_request;
         ClusterStatusResponse status_response;
@@ -94,8 +146,7 @@ public:
         for (const auto& node : status_response. nodes()) {
             if (node.is_healthy()) {
                 std::string target = node.address() + ":" + std::to_string(node.port());
-                auto channel = grpc::CreateChannel(target, grpc::InsecureChannelCredentials());
-                nodes.emplace_back(node.node_id(), StorageService::NewStub(channel));
+                nodes.emplace_back(node.node_id(), channel_pool_.NewStub<StorageService>(target));
             }
         }
 
@@ -107,39 +158,117 @@ public:
         int actual_partitions = (num_partitions > 0) ? 
             std::min(num_partitions, (int)nodes.size()) : nodes.size();
 
-        std::cout << "Distributing to " << actual_partitions << " nodes.. .\n";
+        // Equi-depth splitters from a random sample, so skewed data still
+        // gives every node about the same number of rows
+        PartitionPlan plan = plan_partitions(data, n, actual_partitions);
 
-        
-        int elements_per_node = num_elements / actual_partitions;
-        int remainder = num_elements % actual_partitions;
+        if (verbose) std::cout << "Distributing to " << actual_partitions << " nodes (equi-depth, "
+                  << plan.samples_drawn << " samples, " << plan.attempts << " round"
+                  << (plan.attempts == 1 ? "" : "s") << ", imbalance "
+                  << plan.imbalance * 100.0 << "%)...\n";
 
-        int offset = 0;
+        auto load_start = std::chrono::steady_clock::now();
+        std::vector<LoadColumnResponse> responses(actual_partitions);
+        std::vector<Status> statuses(actual_partitions);
+        std::vector<double> stream_seconds(actual_partitions, 0.0);
+        std::vector<std::unique_ptr<BoundedQueue<std::vector<int>>>> queues;
         for (int i = 0; i < actual_partitions; ++i) {
-            int count = elements_per_node + (i < remainder ?  1 : 0);
+            queues.push_back(std::make_unique<BoundedQueue<std::vector<int>>>(kLoadQueueDepth));
+        }
 
-            LoadColumnRequest request;
-            request.set_column_name(column_name);
-            for (int j = 0; j < count; ++j) {
-                request.add_data(data[offset + j]);
-            }
+        // No overall deadline: a large column legitimately streams for a
+        // long time, and keepalive pings detect a node that went away
+        std::vector<std::thread> senders;
+        for (int i = 0; i < actual_partitions; ++i) {
+            senders.emplace_back([&, i]() {
+                ClientContext context;
+                auto writer = nodes[i].second->LoadColumnStream(&context, &responses[i]);
 
-            LoadColumnResponse response;
-            ClientContext context;
-            context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(60));
+                LoadColumnChunk chunk;
+                chunk.set_column_name(column_name);
+                chunk.set_expected_rows(plan.counts[i]);
+                bool open = writer->Write(chunk);
+                chunk.clear_column_name();
+                chunk.clear_expected_rows();
 
-            Status status = nodes[i]. second->LoadColumn(&context, request, &response);
+                // Keep draining after a failed write so scanners never block
+                std::vector<int> rows;
+                while (queues[i]->pop(rows)) {
+                    if (!open) continue;
+                    chunk.mutable_data()->Assign(rows.begin(), rows.end());
+                    open = writer->Write(chunk);
+                }
+                if (open) writer->WritesDone();
+                statuses[i] = writer->Finish();
+                stream_seconds[i] = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - load_start).count();
+            });
+        }
 
-            if (status. ok() && response. success()) {
-                std::cout << "  " << nodes[i].first << ": loaded " << response.rows_loaded() << " rows\n";
+        unsigned scanners = std::max(1u, std::min(kMaxLoadScanners, std::thread::hardware_concurrency()));
+        std::vector<std::thread> scanner_threads;
+        for (unsigned t = 0; t < scanners; ++t) {
+            size_t begin = n * t / scanners, end = n * (t + 1) / scanners;
+            scanner_threads.emplace_back([&, begin, end]() {
+                std::vector<std::vector<int>> buffers(actual_partitions);
+                for (auto& buffer : buffers) buffer.reserve(kLoadChunkRows);
+                for (size_t r = begin; r < end; ++r) {
+                    int p = partition_of(plan.splitters, data[r]);
+                    buffers[p].push_back(data[r]);
+                    if (buffers[p].size() == kLoadChunkRows) {
+                        queues[p]->push(std::move(buffers[p]));
+                        buffers[p] = std::vector<int>();
+                        buffers[p].reserve(kLoadChunkRows);
+                    }
+                }
+                for (int p = 0; p < actual_partitions; ++p) {
+                    if (!buffers[p].empty()) queues[p]->push(std::move(buffers[p]));
+                }
+            });
+        }
+        for (auto& scanner : scanner_threads) scanner.join();
+        for (auto& queue : queues) queue->close();
+        for (auto& sender : senders) sender.join();
+
+        PartitionMap partition_map;
+        partition_map.set_column_name(column_name);
+        bool all_loaded = true;
+        for (int i = 0; i < actual_partitions; ++i) {
+            std::string range = "[" + (i == 0 ? std::string("-inf") : std::to_string(plan.splitters[i - 1]))
+                + ", " + (i + 1 == actual_partitions ? std::string("+inf") : std::to_string(plan.splitters[i])) + ")";
+            if (statuses[i].ok() && responses[i].success()) {
+                if (verbose) std::cout << "  " << nodes[i].first << ": loaded " << responses[i].rows_loaded()
+                          << " rows " << range << " in " << stream_seconds[i] << "s\n";
             } else {
-                std::cerr << "  " << nodes[i].first << ": FAILED\n";
+                std::cerr << "  " << nodes[i].first << ": FAILED "
+                          << (statuses[i].ok() ? std::string() : statuses[i].error_message()) << "\n";
+                all_loaded = false;
             }
+            partition_map.add_node_ids(nodes[i].first);
+            if (i > 0) partition_map.add_splitters(plan.splitters[i - 1]);
+        }
 
-            offset += count;
+        // Without every partition in place, pruning by this map would hide
+        // rows; an empty map clears any previous one instead
+        if (!all_loaded) {
+            partition_map.clear_node_ids();
+            partition_map.clear_splitters();
+        }
+        {
+            StatusResponse map_response;
+            ClientContext map_context;
+            Status map_status = coordinator_stub_->SetPartitionMap(&map_context, partition_map, &map_response);
+            if (!map_status.ok() || !map_response.success()) {
+                std::cerr << "Failed to register partition map: "
+                          << (map_status.ok() ? map_response.message() : map_status.error_message()) << "\n";
+            }
         }
 
-        std::cout << "Load complete\n\n";
-        return true;
+        if (verbose) {
+            std::cout << "Load complete in " << std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - load_start).count() << "s\n\n";
+        }
+        return all_loaded;
     }
 
     
@@ -157,30 +286,48 @@ public:
         ClientContext context;
         context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(60));
 
+        Span span("client.RangeQuery", TraceContext());
+        span.set_arg("column", column_name);
+        span.set_arg("low", low);
+        span.set_arg("high", high);
+        inject_trace_context(context, span.context());
+
         auto start = std::chrono::high_resolution_clock::now();
         Status status = coordinator_stub_->RangeQuery(&context, request, &response);
         auto end = std::chrono::high_resolution_clock::now();
+        span.end();
 
         double client_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
 
-        if (! status.ok()) {
-            std::cerr << "Query failed: " << status.error_message() << "\n";
+        if (! status.ok() || !response.success()) {
+            std::cerr << "Query failed: "
+                      << (status.ok() ? response.error_message() : status.error_message()) << "\n";
             return false;
         }
 
         std::cout << "\n=== Query Results ===\n";
-        std::cout << "Total count: " << response.total_count() << "\n";
-        std::cout << "Nodes queried: " << response.nodes_queried() << "\n";
-        std::cout << "Server time: " << response.total_time_ms() << " ms\n";
+        std::cout << "Total count: " << response.total_count()
+                  << " (estimated " << response.estimated_total_count() << ")\n";
+        std::cout << "Nodes queried: " << response.nodes_queried()
+                  << " (" << response.nodes_pruned() << " pruned by partition map)\n";
+        std::cout << "Server time: " << response.total_time_ms() << " ms"
+                  << " (queued " << response.queue_time_ms() << " ms, batch of "
+                  << response.batch_size() << ")\n";
         std::cout << "Client time: " << client_time_ms << " ms\n\n";
 
         std::cout << "Per-node results:\n";
         for (const auto& result : response.node_results()) {
-            std::cout << "  " << result.node_id() << ": count=" << result.count();
+            std::cout << "  " << result.node_id() << ": count=" << result.count()
+                      << " (est " << result.estimated_count() << ")";
             if (result.has_stats()) {
                 std::cout << ", touched=" << result.stats().tuples_touched()
+                          << " (est " << result.estimated_touched() << ")"
                           << ", cracks=" << result.stats(). cracks_used()
                           << ", time=" << result.stats().query_time_ms() << "ms";
+                if (result.stats().max_ncrack() > 0) {
+                    std::cout << ", random cracks=" << result.stats().max_ncrack()
+                              << " above " << result.stats().crack_at();
+                }
             }
             std::cout << "\n";
         }
@@ -190,6 +337,606 @@ public:
     }
 
     
+    // Compare a fresh connection per call (how loads used to connect) with
+    // pooled channels: first-RPC latency to each node, then throughput of
+    // tiny queries through the coordinator from several threads.
+    bool RunChannelBenchmark(const std::string& column_name, int queries, int threads) {
+        ClusterStatusRequest status_request;
+        ClusterStatusResponse status_response;
+        ClientContext status_context;
+        if (!coordinator_stub_->GetClusterStatus(&status_context, status_request, &status_response).ok()) {
+            std::cerr << "Failed to get cluster status\n";
+            return false;
+        }
+
+        std::vector<std::string> targets;
+        for (const auto& node : status_response.nodes()) {
+            if (node.is_healthy()) {
+                targets.push_back(node.address() + ":" + std::to_string(node.port()));
+            }
+        }
+
+        const ChannelOptions& options = channel_pool_.options();
+        std::cout << "\n=== Channel Benchmark ===\n";
+        std::cout << targets.size() << " nodes, " << options.subchannels << " subchannels per target\n\n";
+
+        const int kSetupRounds = 20;
+        auto health_check = [](StorageService::Stub* stub) {
+            Empty request;
+            StatusResponse response;
+            ClientContext context;
+            context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+            return stub->HealthCheck(&context, request, &response).ok();
+        };
+
+        for (bool pooled : {false, true}) {
+            double total_ms = 0.0;
+            int calls = 0;
+            for (const auto& target : targets) {
+                if (pooled) {
+                    auto warm_stub = channel_pool_.NewStub<StorageService>(target);
+                    health_check(warm_stub.get());
+                }
+                for (int i = 0; i < kSetupRounds; ++i) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    auto stub = pooled
+                        ? channel_pool_.NewStub<StorageService>(target)
+                        : StorageService::NewStub(ChannelPool::CreateUnpooled(target, options));
+                    bool ok = health_check(stub.get());
+                    auto end = std::chrono::high_resolution_clock::now();
+                    if (!ok) {
+                        std::cerr << "  " << target << ": health check failed\n";
+                        return false;
+                    }
+                    total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+                    calls++;
+                }
+            }
+            std::cout << (pooled ? "Pooled" : "Fresh ") << " channel + first RPC: "
+                      << (calls > 0 ? total_ms / calls : 0.0) << " ms avg over " << calls << " calls\n";
+        }
+        std::cout << "\n";
+
+        for (bool pooled : {false, true}) {
+            std::vector<std::vector<double>> latencies(threads);
+            std::atomic<int> next{0};
+            std::atomic<int> failures{0};
+
+            auto worker = [&](int t) {
+                while (next.fetch_add(1) < queries) {
+                    DistributedRangeQueryRequest request;
+                    request.set_column_name(column_name);
+                    request.set_low(0);
+                    request.set_high(1);
+
+                    DistributedRangeQueryResponse response;
+                    ClientContext context;
+                    context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(30));
+
+                    auto start = std::chrono::high_resolution_clock::now();
+                    auto stub = pooled
+                        ? channel_pool_.NewStub<CoordinatorService>(coordinator_address_)
+                        : CoordinatorService::NewStub(ChannelPool::CreateUnpooled(coordinator_address_, options));
+                    Status status = stub->RangeQuery(&context, request, &response);
+                    auto end = std::chrono::high_resolution_clock::now();
+
+                    if (!status.ok()) failures++;
+                    latencies[t].push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                }
+            };
+
+            auto start = std::chrono::high_resolution_clock::now();
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) workers.emplace_back(worker, t);
+            for (auto& w : workers) w.join();
+            double elapsed_s = std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - start).count();
+
+            std::vector<double> all;
+            for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+            std::sort(all.begin(), all.end());
+            auto percentile = [&](double p) {
+                return all.empty() ? 0.0 : all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+            };
+
+            std::cout << (pooled ? "Pooled" : "Fresh ") << " small queries: "
+                      << queries / elapsed_s << " qps, p50=" << percentile(0.50)
+                      << "ms, p99=" << percentile(0.99) << "ms"
+                      << (failures > 0 ? " (" + std::to_string(failures.load()) + " failed)" : "") << "\n";
+        }
+        std::cout << "\n";
+
+        return true;
+    }
+
+    /**
+     * Issue `queries` random ranges from this one thread through the
+     * asynchronous client, keeping up to `in_flight` per connection
+     * outstanding, and report throughput and latency.
+     */
+    bool RunAsyncBenchmark(const std::string& column_name, int queries, int in_flight) {
+        AsyncClientOptions options;
+        options.channel = channel_pool_.options();
+        options.max_in_flight_per_connection = in_flight;
+        AsyncCrackStoreClient async_client(coordinator_address_, options);
+
+        std::cout << "\n=== Async Client Benchmark ===\n"
+                  << queries << " queries from one thread, " << in_flight << " in flight x "
+                  << options.channel.subchannels << " connections\n\n";
+
+        std::mt19937 rng(140384);
+        std::uniform_int_distribution<int> low_dist(0, INT_MAX - 1 - INT_MAX / 100);
+
+        std::mutex mutex;
+        LatencyHistogram latencies;
+        long long failures = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            int low = low_dist(rng);
+            async_client.RangeQuery(column_name, low, low + INT_MAX / 100, [&](RangeQueryResult&& result) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!result.ok()) {
+                    failures++;
+                    return;
+                }
+                latencies.record(static_cast<uint64_t>(result.latency_ms * 1000.0));
+            });
+        }
+        async_client.Drain();
+        double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Throughput: " << queries / elapsed_s << " qps, " << failures << " failed\n"
+                  << "Latency (ms, including time queued for a slot): p50="
+                  << latencies.value_at_percentile(50) / 1000.0
+                  << " p99=" << latencies.value_at_percentile(99) / 1000.0
+                  << " max=" << latencies.max() / 1000.0 << "\n\n";
+        std::cout.unsetf(std::ios::floatfield);
+
+        return failures == 0;
+    }
+
+    /**
+     * Drive the cluster with `concurrency` threads for a warm-up and a
+     * measured phase.
+     *
+     * Closed loop (no target QPS): each thread sends its next operation as
+     * soon as the previous one returns, which finds peak throughput.
+     *
+     * Open loop: operations are scheduled at fixed 1/QPS intervals and
+     * latency is measured from the scheduled send time, not the actual one.
+     * When the cluster falls behind, the time an operation spent waiting
+     * for a free thread counts against it, so stalls show up in the tail
+     * instead of silently lowering the offered load (coordinated omission).
+     *
+     * Updates insert random values, or delete a value this run inserted
+     * earlier so the column size stays roughly constant.
+     */
+    bool RunLoadGenerator(const std::string& column_name, const LoadGenOptions& options) {
+        using Clock = std::chrono::steady_clock;
+        
+        bool open_loop = options.target_qps > 0.0;
+        std::cout << "\n=== Load Generator ===\n";
+        if (open_loop) {
+            std::cout << "Open loop at " << options.target_qps << " ops/s";
+        } else {
+            std::cout << "Closed loop";
+        }
+        std::cout << ", " << options.concurrency << " threads, " << options.workload
+                  << " queries (selectivity " << options.selectivity << "), "
+                  << options.update_ratio * 100.0 << "% updates\n"
+                  << "Warm-up " << options.warmup_s << "s, measuring " << options.duration_s << "s\n\n";
+        
+        // All threads draw from one generator so the cluster sees a single
+        // workload's query sequence
+        std::vector<char> workload_name(options.workload.begin(), options.workload.end());
+        workload_name.push_back('\0');
+        int width = static_cast<int>(options.selectivity * options.domain);
+        std::unique_ptr<Workload> workload = std::make_unique<Workload>(
+            options.domain, workload_name.data(), width);
+        std::mutex workload_mutex;
+        auto next_query = [&](int& a, int& b) {
+            std::lock_guard<std::mutex> lock(workload_mutex);
+            if (!workload->query(a, b)) {
+                // Finite workloads (e.g. sequential scans) start over
+                workload = std::make_unique<Workload>(options.domain, workload_name.data(), width);
+                workload->query(a, b);
+            }
+        };
+        
+        const auto start = Clock::now() + std::chrono::milliseconds(10);
+        const auto measure_start = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.warmup_s));
+        const auto stop = measure_start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.duration_s));
+        const auto interval = open_loop
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.target_qps))
+            : Clock::duration::zero();
+        
+        struct WorkerStats {
+            LatencyHistogram queries;   // Microseconds
+            LatencyHistogram updates;
+            long long failures = 0;
+            long long rows = 0;
+        };
+        std::vector<WorkerStats> stats(options.concurrency);
+        std::atomic<long long> next_slot{0};
+        
+        auto worker = [&](int t) {
+            std::mt19937 rng(140384 + t);
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            std::uniform_int_distribution<int> any_value(0, options.domain);
+            std::vector<int> inserted;
+            
+            while (true) {
+                // Open loop: claim the next slot of the global schedule
+                Clock::time_point intended;
+                if (open_loop) {
+                    intended = start + interval * next_slot.fetch_add(1);
+                    if (intended >= stop || Clock::now() >= stop) break;
+                    std::this_thread::sleep_until(intended);
+                } else {
+                    intended = Clock::now();
+                    if (intended >= stop) break;
+                }
+                
+                bool is_update = coin(rng) < options.update_ratio;
+                ClientContext context;
+                context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(30));
+                Status status;
+                bool ok;
+                
+                if (is_update) {
+                    UpdateRequest request;
+                    request.set_column_name(column_name);
+                    if (!inserted.empty() && coin(rng) < 0.5) {
+                        size_t victim = rng() % inserted.size();
+                        request.add_deletes(inserted[victim]);
+                        inserted[victim] = inserted.back();
+                        inserted.pop_back();
+                    } else {
+                        int value = any_value(rng);
+                        request.add_inserts(value);
+                        inserted.push_back(value);
+                    }
+                    UpdateResponse response;
+                    status = coordinator_stub_->Update(&context, request, &response);
+                    ok = status.ok() && response.success();
+                } else {
+                    int a, b;
+                    next_query(a, b);
+                    DistributedRangeQueryRequest request;
+                    request.set_column_name(column_name);
+                    request.set_low(a);
+                    request.set_high(b);
+                    DistributedRangeQueryResponse response;
+                    status = coordinator_stub_->RangeQuery(&context, request, &response);
+                    ok = status.ok() && response.success();
+                    if (ok) stats[t].rows += response.total_count();
+                }
+                
+                auto end = Clock::now();
+                if (intended < measure_start) continue;
+                if (!ok) {
+                    stats[t].failures++;
+                    continue;
+                }
+                uint64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(end - intended).count();
+                (is_update ? stats[t].updates : stats[t].queries).record(latency_us);
+            }
+        };
+        
+        std::vector<std::thread> workers;
+        for (int t = 0; t < options.concurrency; ++t) workers.emplace_back(worker, t);
+        for (auto& w : workers) w.join();
+        
+        WorkerStats total;
+        for (const WorkerStats& s : stats) {
+            total.queries.merge(s.queries);
+            total.updates.merge(s.updates);
+            total.failures += s.failures;
+            total.rows += s.rows;
+        }
+        
+        // Operations still queued at the end were never sent; their
+        // latency is unknown, so they are reported rather than recorded
+        long long completed = total.queries.count() + total.updates.count() + total.failures;
+        double achieved = completed / options.duration_s;
+        std::cout << "Throughput: " << achieved << " ops/s, " << total.failures << " failed\n";
+        if (open_loop) {
+            long long scheduled = static_cast<long long>(options.target_qps * options.duration_s);
+            if (completed < scheduled) {
+                std::cout << "Below target: " << scheduled - completed
+                          << " scheduled operations not sent (cluster or client threads saturated)\n";
+            }
+        }
+        std::cout << "\n";
+        
+        auto summarize = [](const char* label, const LatencyHistogram& h) {
+            if (h.count() == 0) return;
+            std::cout << std::fixed << std::setprecision(3)
+                      << label << " (" << h.count() << ", ms): mean=" << h.mean() / 1000.0
+                      << " p50=" << h.value_at_percentile(50) / 1000.0
+                      << " p90=" << h.value_at_percentile(90) / 1000.0
+                      << " p99=" << h.value_at_percentile(99) / 1000.0
+                      << " p99.9=" << h.value_at_percentile(99.9) / 1000.0
+                      << " max=" << h.max() / 1000.0 << "\n";
+            std::cout.unsetf(std::ios::floatfield);
+        };
+        summarize("Queries", total.queries);
+        summarize("Updates", total.updates);
+        if (total.queries.count() > 0) {
+            std::cout << "Rows per query: " << total.rows / static_cast<long long>(total.queries.count()) << "\n";
+        }
+        
+        if (!options.hdr_file.empty()) {
+            std::ofstream out(options.hdr_file);
+            out << "# Query latency (ms)\n";
+            total.queries.print_percentiles(out, 1000.0);
+            if (total.updates.count() > 0) {
+                out << "\n# Update latency (ms)\n";
+                total.updates.print_percentiles(out, 1000.0);
+            }
+            if (!out) {
+                std::cerr << "Failed to write " << options.hdr_file << "\n";
+                return false;
+            }
+            std::cout << "Percentile distribution written to " << options.hdr_file << "\n";
+        }
+        std::cout << "\n";
+        
+        return total.failures == 0;
+    }
+
+    /**
+     * Replay a scrack experiment against the cluster: the same arguments,
+     * query sequence (src/workload.h) and update patterns (same seeds) as
+     * src/tester.h, writing the same per-query res/metrics.mtr and res/res_q,
+     * so run.sh, res_parser and res_table treat the run like any other
+     * program.
+     *
+     * Each update round is sent as one Update RPC. The cluster only answers
+     * counts, so "view" runs as "count". Metrics the engine doesn't split
+     * out (trash, ripple, tree and merge times) are written as zeros;
+     * crack_t is the slowest node's engine time and search_t the client's
+     * round trip.
+     *
+     * A trace:FILE workload replays a query trace (src/query_trace.h), its
+     * updates batched per query, paced by SCRACK_REPLAY_SPEED; with
+     * SCRACK_RECORD=FILE the run is recorded as one.
+     */
+    bool RunReplay(const std::string& column_name, const std::string& file_path, int Q,
+                   double selectivity, const std::string& query_workload,
+                   const std::string& update_workload, const std::string& returning, int TLE) {
+        std::vector<int> arr;
+        if (!ReadColumnFile(file_path, arr) || arr.empty()) {
+            return false;
+        }
+        int N = static_cast<int>(arr.size());
+        int K1 = 0, K2 = 0, ROLLV = 1010000000;
+        int mx = *std::max_element(arr.begin(), arr.end());
+        fprintf(stderr, "%15s %15s %5s S=%-8.0lf N=%-9d(%10d) I=", "replay", query_workload.c_str(),
+                update_workload.c_str(), selectivity * mx, N, mx);
+        
+        std::vector<char> workload_name(query_workload.begin(), query_workload.end());
+        workload_name.push_back('\0');
+        Workload W(mx, workload_name.data(), static_cast<int>(selectivity * mx));
+        
+        const std::string& updatew = update_workload;
+        const QueryTraceReader* trace = W.recording();
+        std::string prepare = updatew;  // the data as the traced queries saw it
+        if (trace) {
+            if (updatew != "NOUP") {
+                fprintf(stderr, "\nA trace replays its own updates: use NOUP\n");
+                return false;
+            }
+            prepare = trace->header.updates;
+        }
+        if (prepare == "ROLL") {
+            for (int i = 0; i < N; i++) {
+                if (arr[i] <= ROLLV) arr[i] += ROLLV;
+            }
+        } else if (prepare == "APPEND") {
+            if (!trace) K1 = 1000, K2 = -1000;
+            if (N < 500000000) {
+                fprintf(stderr, "\nAPPEND needs at least 500000000 rows (read %d)\n", N);
+                return false;
+            }
+            N = 10000000;
+        }
+        
+        using Clock = std::chrono::steady_clock;
+        auto seconds_since = [](Clock::time_point t) {
+            return std::chrono::duration<double>(Clock::now() - t).count();
+        };
+        
+        // Like tester.h's init(): only the first N rows are loaded
+        auto init_start = Clock::now();
+        if (!LoadColumn(column_name, arr.data(), N, 0, false)) {
+            fprintf(stderr, "\nLoading %s failed\n", column_name.c_str());
+            return false;
+        }
+        double total_t = seconds_since(init_start);
+        fprintf(stderr, "%.3lf ", total_t);
+        
+        const char* record = getenv("SCRACK_RECORD");
+        std::unique_ptr<QueryTraceWriter> recorder;
+        if (record && *record) {
+            recorder = std::make_unique<QueryTraceWriter>(record, updatew.c_str());
+            recorder->restart(N);
+        }
+        ReplayClock pace;
+        
+        if (updatew == "NOUP") K1 = Q + 1, K2 = 0;
+        else if (updatew == "LFHV") K1 = 1000, K2 = 1000;
+        else if (updatew == "HFLV") K1 = 10, K2 = 10;
+        else if (updatew == "ROLL") K1 = 10, K2 = -10, std::sort(arr.begin(), arr.begin() + N);
+        else if (updatew == "TRASH") K1 = 10, K2 = -10000;
+        else if (updatew == "DELETE") K1 = 1000, K2 = -100000;
+        else if (updatew == "APPEND") {}
+        else { fprintf(stderr, "Update workload \"%s\" is not found!\n", updatew.c_str()); return false; }
+        
+        if (returning != "view" && returning != "count") {
+            fprintf(stderr, "Unknown query result type \"%s\" (view or count)\n", returning.c_str());
+            return false;
+        }
+        fprintf(stderr, "C");
+        
+        Random r(160284);
+        MetricsRecorder M("res/metrics.mtr", Q);
+        int* result_size_m = M.ints("result_size");
+        int* examined_m = M.ints("examined");
+        int* n_cracks_m = M.ints("n_cracks");
+        int* n_touched_m = M.ints("n_touched");
+        int* n_trash_m = M.ints("n_trash");
+        int* n_rippled_m = M.ints("n_rippled");
+        double* update_t_m = M.doubles("update_t");
+        double* mri_t_m = M.doubles("mri_t");
+        double* mrd_t_m = M.doubles("mrd_t");
+        double* crack_t_m = M.doubles("crack_t");
+        double* tree_t_m = M.doubles("tree_t");
+        double* search_t_m = M.doubles("search_t");
+        double* total_t_m = M.doubles("total_t");
+        
+        auto send_update = [&](const UpdateRequest& request) {
+            UpdateResponse response;
+            ClientContext context;
+            Status status = coordinator_stub_->Update(&context, request, &response);
+            if (!status.ok() || !response.success()) {
+                fprintf(stderr, "\nUpdate failed: %s\n",
+                        (status.ok() ? response.error_message() : status.error_message()).c_str());
+                return false;
+            }
+            return true;
+        };
+        
+        for (int a, b, i = 0, ROLL = N - 1; i < Q; i++) {
+            if (total_t > TLE) { fprintf(stderr, "X"); Q = i; break; }
+            if (!(i & (i + 1))) fprintf(stderr, ".");
+            
+            double update_t = (i == 0) ? total_t : 0, search_t = 0;
+            
+            bool ok = W.query(a, b);
+            if (!ok) { Q = i; break; }
+            
+            // Same update rounds as tester.h, each batched into one request
+            if (trace || (i + 1) % K1 == 0) {
+                UpdateRequest request;
+                request.set_column_name(column_name);
+                if (trace) {
+                    int nu;
+                    const QueryTraceRecord* u = W.updates(nu);
+                    for (int j = 0; j < nu; j++) {
+                        if (u[j].kind == QT_INSERT) request.add_inserts(u[j].a);
+                        else request.add_deletes(u[j].a);
+                    }
+                    if (nu) pace.wait(W.updates_at());
+                } else if (K2 == -10000) {     // TRASH: one million inserts, once
+                    for (int j = 0; i == K1 - 1 && j < 1000000; j++) {
+                        request.add_inserts(abs(r.nextInt()));
+                    }
+                    fprintf(stderr, "H");
+                    K1 *= 10000;
+                } else if (K2 == -1000) {
+                    if (N < 580000000) {
+                        for (int j = 0; j < 10000000; j++) {
+                            request.add_inserts(arr[N++]);
+                        }
+                        fprintf(stderr, "A");
+                    }
+                } else if (K2 == -100000) {
+                    for (int j = 0; j < 1000; j++) {
+                        int idx = r.nextInt(N);
+                        request.add_deletes(arr[idx]);
+                        arr[idx] = arr[--N];
+                    }
+                } else if (K2 < 0) {
+                    for (int j = 0; j > K2; j--) {
+                        request.add_deletes(arr[ROLL]);
+                        request.add_inserts(ROLLV);
+                        arr[ROLL--] = ROLLV--;
+                        if (ROLL < 0) ROLL = N - 1;
+                    }
+                } else if (K2 > 0) {
+                    for (int j = 0; j < K2; j++) {
+                        int idx = r.nextInt(N), val = abs(r.nextInt());
+                        request.add_deletes(arr[idx]);
+                        request.add_inserts(val);
+                        arr[idx] = val;
+                    }
+                }
+                
+                if (request.inserts_size() > 0 || request.deletes_size() > 0) {
+                    if (recorder) {
+                        // in the order the storage nodes apply them
+                        for (int v : request.inserts()) recorder->add(QT_INSERT, v);
+                        for (int v : request.deletes()) recorder->add(QT_DELETE, v);
+                    }
+                    auto update_start = Clock::now();
+                    if (!send_update(request)) return false;
+                    update_t += seconds_since(update_start);
+                }
+            }
+            if (K2 == -10) {
+                a = ROLLV;
+                b = ROLLV + 10000;
+            }
+            if (trace) pace.wait(W.issued_at());
+            if (recorder) recorder->add(QT_COUNT, a, b);
+            
+            DistributedRangeQueryRequest request;
+            request.set_column_name(column_name);
+            request.set_low(a);
+            request.set_high(b);
+            DistributedRangeQueryResponse response;
+            ClientContext context;
+            
+            auto search_start = Clock::now();
+            Status status = coordinator_stub_->RangeQuery(&context, request, &response);
+            search_t = seconds_since(search_start);
+            if (!status.ok() || !response.success()) {
+                fprintf(stderr, "\nQuery %d [%d, %d) failed: %s\n", i, a, b,
+                        (status.ok() ? response.error_message() : status.error_message()).c_str());
+                return false;
+            }
+            
+            int n_touched = 0, n_cracks = 0;
+            double crack_t = 0;
+            for (const auto& node_result : response.node_results()) {
+                n_touched += node_result.stats().tuples_touched();
+                n_cracks += node_result.stats().cracks_used();
+                crack_t = std::max(crack_t, node_result.stats().query_time_ms() / 1000.0);
+            }
+            
+            if (i == 0) fprintf(stderr, "F=%.3lf ", search_t);
+            
+            total_t += update_t + search_t;
+            
+            result_size_m[i] = static_cast<int>(response.total_count());
+            examined_m[i] = n_touched;
+            n_cracks_m[i] = n_cracks;
+            n_touched_m[i] = n_touched;
+            n_trash_m[i] = 0;
+            n_rippled_m[i] = 0;
+            mri_t_m[i] = 0.0;
+            mrd_t_m[i] = 0.0;
+            crack_t_m[i] = crack_t;
+            tree_t_m[i] = 0.0;
+            search_t_m[i] = search_t;
+            update_t_m[i] = update_t;
+            total_t_m[i] = update_t + search_t;
+            M.next();
+        }
+        fprintf(stderr, " T=%9.6lf Q=%d\n", total_t, Q);
+        
+        FILE* QF = fopen("res/res_q", "w");
+        if (!QF) return false;
+        fprintf(QF, "%d\n", Q);
+        fclose(QF);
+        return true;
+    }
+
     bool RunBenchmark(const std::string& column_name, int low, int high, int iterations) {
         std::cout << "\n=== Running Benchmark ===\n";
         std::cout << "Query: [" << low << ", " << high << ") x " << iterations << " iterations\n\n";
@@ -203,9 +950,14 @@ public:
             DistributedRangeQueryResponse response;
             ClientContext context;
 
+            Span span("client.RangeQuery", TraceContext());
+            span.set_arg("iteration", i);
+            inject_trace_context(context, span.context());
+
             auto start = std::chrono::high_resolution_clock::now();
             Status status = coordinator_stub_->RangeQuery(&context, request, &response);
             auto end = std::chrono::high_resolution_clock::now();
+            span.end();
 
             double time_ms = std::chrono::duration<double, std::milli>(end - start).count();
 
@@ -233,7 +985,26 @@ public:
     }
 
 private:
+    static bool ReadColumnFile(const std::string& file_path, std::vector<int>& data) {
+        std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+        if (! file) {
+            std::cerr << "Failed to open file: " << file_path << "\n";
+            return false;
+        }
+
+        std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        data.resize(size / sizeof(int));
+
+        if (! file.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(int))) {
+            std::cerr << "Failed to read file\n";
+            return false;
+        }
+        return true;
+    }
+
     std::string coordinator_address_;
+    ChannelPool channel_pool_;
     std::unique_ptr<CoordinatorService::Stub> coordinator_stub_;
 };
 
@@ -242,20 +1013,41 @@ void print_usage(const char* program) {
     std::cerr << "Usage: " << program << " [options] <command> [args]\n"
               << "\nOptions:\n"
               << "  --coordinator ADDR   Coordinator address (default: localhost:50050)\n"
+              << "  --trace-file PATH    Write Chrome trace-event JSON spans to PATH\n"
+              << "  --subchannels N      Connections per server (default: 1)\n"
               << "\nCommands:\n"
               << "  status                          Get cluster status\n"
               << "  load <column> <file>            Load binary data file to cluster\n"
               << "  query <column> <low> <high>     Execute range query\n"
               << "  benchmark <column> <low> <high> <iterations>  Run repeated queries\n"
+              << "  bench-channels <column> <queries> <threads>  Compare fresh vs pooled channels\n"
+              << "  bench-async <column> <queries> <in-flight>  Pipelined queries from one thread\n"
+              << "  loadgen <column> [loadgen options]  Drive sustained load, report latency percentiles\n"
+              << "  replay <column> <file> <queries> <selectivity> <workload> <update-workload> <view|count> <time-limit>\n"
+              << "                                  Run a src/tester.h experiment on the cluster, writing res/*.gz\n"
+              << "  merge-traces <out> <in>...      Combine --trace-file outputs into one trace\n"
+              << "\nLoadgen options:\n"
+              << "  --concurrency C      Client threads (default: 4)\n"
+              << "  --qps Q              Open loop at Q ops/s; omit for closed loop\n"
+              << "  --warmup S           Unrecorded warm-up seconds (default: 5)\n"
+              << "  --duration S         Measured seconds (default: 30)\n"
+              << "  --workload NAME      src/workload.h workload (default: Random)\n"
+              << "  --selectivity F      Query width as a fraction of the domain (default: 0.01)\n"
+              << "  --domain N           Queries fall in [0, N] (default: 2147483646)\n"
+              << "  --update-ratio F     Fraction of operations that are inserts/deletes (default: 0)\n"
+              << "  --hdr-file PATH      Write percentile distributions in HdrHistogram format\n"
               << "\nExamples:\n"
               << "  " << program << " status\n"
               << "  " << program << " load prices /app/data/100000000.data\n"
               << "  " << program << " query prices 1000000 2000000\n"
-              << "  " << program << " benchmark prices 1000000 2000000 10\n";
+              << "  " << program << " benchmark prices 1000000 2000000 10\n"
+              << "  " << program << " loadgen prices --qps 2000 --concurrency 16 --update-ratio 0.1\n";
 }
 
 int main(int argc, char** argv) {
     std::string coordinator_address = "localhost:50050";
+    std::string trace_file;
+    ChannelOptions channel_options;
     int arg_index = 1;
 
     // Parse options
@@ -263,6 +1055,10 @@ int main(int argc, char** argv) {
         std::string arg = argv[arg_index];
         if (arg == "--coordinator" && arg_index + 1 < argc) {
             coordinator_address = argv[++arg_index];
+        } else if (arg == "--subchannels" && arg_index + 1 < argc) {
+            channel_options.subchannels = std::stoi(argv[++arg_index]);
+        } else if (arg == "--trace-file" && arg_index + 1 < argc) {
+            trace_file = argv[++arg_index];
         } else if (arg == "--help") {
             print_usage(argv[0]);
             return 0;
@@ -280,10 +1076,31 @@ int main(int argc, char** argv) {
     }
 
     std::string command = argv[arg_index++];
-    CrackStoreClient client(coordinator_address);
 
+    if (command == "merge-traces") {
+        if (arg_index + 1 >= argc) {
+            std::cerr << "Usage: merge-traces <out> <in>...\n";
+            return 1;
+        }
+        std::string output = argv[arg_index++];
+        std::vector<std::string> inputs(argv + arg_index, argv + argc);
+        if (!merge_trace_files(output, inputs)) {
+            std::cerr << "Failed to merge traces into " << output << "\n";
+            return 1;
+        }
+        std::cout << "Merged " << inputs.size() << " trace files into " << output << "\n";
+        return 0;
+    }
+
+    CrackStoreClient client(coordinator_address, channel_options);
+
+    if (!trace_file.empty()) {
+        Tracer::instance().enable(trace_file, "client");
+    }
+
+    bool ok;
     if (command == "status") {
-        return client.GetClusterStatus() ? 0 : 1;
+        ok = client.GetClusterStatus();
 
     } else if (command == "load") {
         if (arg_index + 1 >= argc) {
@@ -292,7 +1109,7 @@ int main(int argc, char** argv) {
         }
         std::string column = argv[arg_index++];
         std::string file = argv[arg_index++];
-        return client.LoadColumnFromFile(column, file) ? 0 : 1;
+        ok = client.LoadColumnFromFile(column, file);
 
     } else if (command == "query") {
         if (arg_index + 2 >= argc) {
@@ -302,7 +1119,7 @@ int main(int argc, char** argv) {
         std::string column = argv[arg_index++];
         int low = std::stoi(argv[arg_index++]);
         int high = std::stoi(argv[arg_index++]);
-        return client.RangeQuery(column, low, high) ? 0 : 1;
+        ok = client.RangeQuery(column, low, high);
 
     } else if (command == "benchmark") {
         if (arg_index + 3 >= argc) {
@@ -313,11 +1130,83 @@ int main(int argc, char** argv) {
         int low = std::stoi(argv[arg_index++]);
         int high = std::stoi(argv[arg_index++]);
         int iterations = std::stoi(argv[arg_index++]);
-        return client.RunBenchmark(column, low, high, iterations) ? 0 : 1;
+        ok = client.RunBenchmark(column, low, high, iterations);
+
+    } else if (command == "bench-channels") {
+        if (arg_index + 2 >= argc) {
+            std::cerr << "Usage: bench-channels <column> <queries> <threads>\n";
+            return 1;
+        }
+        std::string column = argv[arg_index++];
+        int queries = std::stoi(argv[arg_index++]);
+        int threads = std::stoi(argv[arg_index++]);
+        ok = client.RunChannelBenchmark(column, queries, threads);
+
+    } else if (command == "bench-async") {
+        if (arg_index + 2 >= argc) {
+            std::cerr << "Usage: bench-async <column> <queries> <in-flight>\n";
+            return 1;
+        }
+        std::string column = argv[arg_index++];
+        int queries = std::stoi(argv[arg_index++]);
+        int in_flight = std::stoi(argv[arg_index++]);
+        ok = client.RunAsyncBenchmark(column, queries, in_flight);
+
+    } else if (command == "replay") {
+        if (arg_index + 7 >= argc) {
+            std::cerr << "Usage: replay <column> <file> <queries> <selectivity> <workload> "
+                      << "<update-workload> <view|count> <time-limit>\n";
+            return 1;
+        }
+        std::string column = argv[arg_index++];
+        std::string file = argv[arg_index++];
+        int queries = std::stoi(argv[arg_index++]);
+        double selectivity = std::stod(argv[arg_index++]);
+        std::string workload = argv[arg_index++];
+        std::string update_workload = argv[arg_index++];
+        std::string returning = argv[arg_index++];
+        int time_limit = std::stoi(argv[arg_index++]);
+        ok = client.RunReplay(column, file, queries, selectivity, workload,
+                              update_workload, returning, time_limit);
+
+    } else if (command == "loadgen") {
+        if (arg_index >= argc) {
+            std::cerr << "Usage: loadgen <column> [loadgen options]\n";
+            return 1;
+        }
+        std::string column = argv[arg_index++];
+        LoadGenOptions options;
+        for (; arg_index < argc; ++arg_index) {
+            std::string arg = argv[arg_index];
+            if (arg_index + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                return 1;
+            }
+            std::string value = argv[++arg_index];
+            if (arg == "--concurrency") options.concurrency = std::max(1, std::stoi(value));
+            else if (arg == "--qps") options.target_qps = std::stod(value);
+            else if (arg == "--warmup") options.warmup_s = std::stod(value);
+            else if (arg == "--duration") options.duration_s = std::stod(value);
+            else if (arg == "--workload") options.workload = value;
+            else if (arg == "--selectivity") options.selectivity = std::stod(value);
+            else if (arg == "--domain") options.domain = std::stoi(value);
+            else if (arg == "--update-ratio") options.update_ratio = std::stod(value);
+            else if (arg == "--hdr-file") options.hdr_file = value;
+            else {
+                std::cerr << "Unknown loadgen option: " << arg << "\n";
+                return 1;
+            }
+        }
+        ok = client.RunLoadGenerator(column, options);
 
     } else {
         std::cerr << "Unknown command: " << command << "\n";
         print_usage(argv[0]);
         return 1;
     }
+
+    if (!trace_file.empty() && !Tracer::instance().flush()) {
+        std::cerr << "Failed to write trace to " << trace_file << "\n";
+    }
+    return ok ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+#ifndef CHANNEL_POOL_H
+#define CHANNEL_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+
+/**
+ * Shared gRPC channels.
+ *
+ * Channels are expensive to set up (DNS, TCP and HTTP/2 handshakes) and
+ * cheap to reuse, so every process keeps one pool and asks it for a
+ * channel per target instead of calling grpc::CreateChannel itself.
+ *
+ * A target can be backed by several subchannels, each its own TCP
+ * connection, handed out round-robin so parallel streams to one node do
+ * not queue behind HTTP/2 flow control on a single connection. Channels
+ * keep their connection alive with pings so an idle node does not pay the
+ * handshake again on its next query.
+ */
+
+namespace crackstore {
+
+struct ChannelOptions {
+    int subchannels = 1;                    // Connections per target
+    int keepalive_time_ms = 30000;          // Ping interval on an idle connection
+    int keepalive_timeout_ms = 10000;       // Drop the connection if a ping is not acked
+    int max_message_bytes = 512 << 20;      // Column loads ship whole partitions in one message
+};
+
+
+// Channel arguments for keepalive and message limits, shared by pooled and
+// in-process channels
+inline grpc::ChannelArguments MakeChannelArguments(const ChannelOptions& options) {
+    grpc::ChannelArguments args;
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, options.keepalive_time_ms);
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, options.keepalive_timeout_ms);
+    args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+    args.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+    args.SetMaxReceiveMessageSize(options.max_message_bytes);
+    args.SetMaxSendMessageSize(options.max_message_bytes);
+    return args;
+}
+
+
+class ChannelPool {
+public:
+    explicit ChannelPool(ChannelOptions options = ChannelOptions()) : options_(options) {
+        if (options_.subchannels < 1) options_.subchannels = 1;
+    }
+
+    ChannelPool(const ChannelPool&) = delete;
+    ChannelPool& operator=(const ChannelPool&) = delete;
+
+    /**
+     * Channel to `target` ("host:port"), created on first use. Successive
+     * calls rotate over the target's subchannels.
+     */
+    std::shared_ptr<grpc::Channel> Get(const std::string& target) {
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(target);
+            if (it == entries_.end()) {
+                it = entries_.emplace(target, CreateEntry(target)).first;
+            }
+            entry = it->second;
+        }
+        size_t index = entry->next.fetch_add(1, std::memory_order_relaxed);
+        return entry->channels[index % entry->channels.size()];
+    }
+
+    template <typename Service>
+    std::unique_ptr<typename Service::Stub> NewStub(const std::string& target) {
+        return Service::NewStub(Get(target));
+    }
+
+    /**
+     * Connect every subchannel of `target` now instead of on the first RPC.
+     * Returns false if any of them is not ready before the timeout.
+     */
+    bool Warm(const std::string& target, std::chrono::milliseconds timeout) {
+        Get(target);
+        std::vector<std::shared_ptr<grpc::Channel>> channels;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            channels = entries_.at(target)->channels;
+        }
+        auto deadline = std::chrono::system_clock::now() + timeout;
+        bool ready = true;
+        for (auto& channel : channels) {
+            ready = channel->WaitForConnected(deadline) && ready;
+        }
+        return ready;
+    }
+
+    // Forget `target`; in-flight calls keep their channel alive
+    void Evict(const std::string& target) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.erase(target);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    const ChannelOptions& options() const { return options_; }
+
+    /**
+     * Build a standalone channel with the pool's settings, bypassing the
+     * pool. Used to measure the cost of not pooling.
+     */
+    static std::shared_ptr<grpc::Channel> CreateUnpooled(const std::string& target,
+                                                         const ChannelOptions& options,
+                                                         int subchannel_index = 0) {
+        grpc::ChannelArguments args = MakeChannelArguments(options);
+
+        // gRPC shares connections between channels with identical arguments
+        // through a global subchannel pool; a local pool plus a distinct
+        // index gives each subchannel its own connection
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        args.SetInt("crackstore.subchannel_index", subchannel_index);
+
+        return grpc::CreateCustomChannel(target, grpc::InsecureChannelCredentials(), args);
+    }
+
+private:
+    struct Entry {
+        std::vector<std::shared_ptr<grpc::Channel>> channels;
+        std::atomic<size_t> next{0};
+    };
+
+    std::shared_ptr<Entry> CreateEntry(const std::string& target) const {
+        auto entry = std::make_shared<Entry>();
+        for (int i = 0; i < options_.subchannels; ++i) {
+            entry->channels.push_back(CreateUnpooled(target, options_, i));
+        }
+        return entry;
+    }
+
+    ChannelOptions options_;
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Entry>> entries_;
+};
+
+
+/**
+ * Server-side counterpart of ChannelOptions: accept messages as large as
+ * pooled clients send and tolerate their keepalive pings on idle
+ * connections (by default gRPC answers frequent pings with GOAWAY).
+ */
+inline void ConfigureServerBuilder(grpc::ServerBuilder& builder,
+                                   const ChannelOptions& options = ChannelOptions()) {
+    builder.SetMaxReceiveMessageSize(options.max_message_bytes);
+    builder.SetMaxSendMessageSize(options.max_message_bytes);
+    builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+    builder.AddChannelArgument(GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS,
+                               options.keepalive_time_ms / 2);
+    builder.AddChannelArgument(GRPC_ARG_HTTP2_MAX_PING_STRIKES, 0);
+}
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+/**
+ * HDR-style latency histogram.
+ *
+ * Log-linear buckets: values below 128 are counted exactly, above that each
+ * power-of-two range is split into 64 equal sub-buckets, so any recorded
+ * value is reported within 1/64 (~1.6%) of its true value over the whole
+ * 64-bit range with a few thousand counters. Histograms from several
+ * threads merge by adding counters.
+ */
+
+namespace crackstore {
+
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 7;
+    static constexpr uint64_t kSubBuckets = 1ULL << kSubBucketBits;     // 128
+    static constexpr uint64_t kHalfSubBuckets = kSubBuckets / 2;        // 64
+
+    LatencyHistogram() : counts_(bucket_index(std::numeric_limits<uint64_t>::max()) + 1, 0) {}
+
+    void record(uint64_t value, uint64_t count = 1) {
+        counts_[bucket_index(value)] += count;
+        total_ += count;
+        sum_ += static_cast<double>(value) * count;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_ = 0;
+        sum_ = 0.0;
+        min_ = std::numeric_limits<uint64_t>::max();
+        max_ = 0;
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t min() const { return total_ > 0 ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return total_ > 0 ? sum_ / total_ : 0.0; }
+
+    /**
+     * Smallest recorded value (to bucket precision) at or below which
+     * `percentile` percent of the samples fall.
+     */
+    uint64_t value_at_percentile(double percentile) const {
+        if (total_ == 0) return 0;
+        double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total_)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= target) return std::min(bucket_high(i), max_);
+        }
+        return max_;
+    }
+
+    /**
+     * Percentile distribution in the HdrHistogram text format (.hgrm), so
+     * the HdrHistogram plotter can chart it. Values are divided by
+     * `unit_scale`, e.g. 1000 to print microsecond samples as milliseconds.
+     */
+    void print_percentiles(std::ostream& out, double unit_scale = 1.0, int ticks_per_half = 5) const {
+        out << std::setw(12) << "Value" << " " << std::setw(14) << "Percentile" << " "
+            << std::setw(10) << "TotalCount" << " " << std::setw(14) << "1/(1-Percentile)" << "\n\n";
+        out << std::fixed;
+
+        // Step halves the remaining distance to 100% every `ticks_per_half` lines
+        double percentile = 0.0;
+        double step = 100.0 / (2.0 * ticks_per_half);
+        for (int tick = 0; total_ > 0; ++tick) {
+            uint64_t value = value_at_percentile(percentile);
+            uint64_t below = count_at_or_below(value);
+            out << std::setprecision(3) << std::setw(12) << value / unit_scale << " "
+                << std::setprecision(12) << std::setw(14) << percentile / 100.0 << " "
+                << std::setw(10) << below << " ";
+            if (percentile < 100.0) {
+                out << std::setprecision(2) << std::setw(14) << 1.0 / (1.0 - percentile / 100.0);
+            }
+            out << "\n";
+
+            if (percentile >= 100.0 || below >= total_) {
+                if (percentile < 100.0) {
+                    out << std::setprecision(3) << std::setw(12) << max_ / unit_scale << " "
+                        << std::setprecision(12) << std::setw(14) << 1.0 << " "
+                        << std::setw(10) << total_ << "\n";
+                }
+                break;
+            }
+            percentile += step;
+            if ((tick + 1) % ticks_per_half == 0) step /= 2.0;
+        }
+
+        out << std::setprecision(3)
+            << "#[Mean    = " << std::setw(12) << mean() / unit_scale
+            << ", StdDeviation   = " << std::setw(12) << stddev() / unit_scale << "]\n"
+            << "#[Max     = " << std::setw(12) << max_ / unit_scale
+            << ", Total count    = " << std::setw(12) << total_ << "]\n"
+            << "#[Buckets = " << std::setw(12) << counts_.size()
+            << ", SubBuckets     = " << std::setw(12) << kSubBuckets << "]\n";
+        out.unsetf(std::ios::floatfield);
+    }
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    double sum_ = 0.0;
+    uint64_t min_ = std::numeric_limits<uint64_t>::max();
+    uint64_t max_ = 0;
+
+    // Values [0, 128) map to themselves; above that, bucket b covers
+    // [64 << b, 128 << b) in 64 steps of 1 << b
+    static size_t bucket_index(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - (kSubBucketBits - 1);
+        return static_cast<size_t>(kSubBuckets + (shift - 1) * kHalfSubBuckets +
+                                   ((value >> shift) - kHalfSubBuckets));
+    }
+
+    // Largest value that maps to bucket i
+    static uint64_t bucket_high(size_t i) {
+        if (i < kSubBuckets) return i;
+        uint64_t shift = (i - kSubBuckets) / kHalfSubBuckets + 1;
+        uint64_t sub = (i - kSubBuckets) % kHalfSubBuckets + kHalfSubBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    uint64_t count_at_or_below(uint64_t value) const {
+        uint64_t seen = 0;
+        size_t last = bucket_index(value);
+        for (size_t i = 0; i <= last; ++i) seen += counts_[i];
+        return seen;
+    }
+
+    double stddev() const {
+        if (total_ == 0) return 0.0;
+        double m = mean(), sq = 0.0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            if (counts_[i] == 0) continue;
+            double d = static_cast<double>(bucket_high(i)) - m;
+            sq += d * d * counts_[i];
+        }
+        return std::sqrt(sq / total_);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,338 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <grpcpp/grpcpp.h>
+
+/**
+ * Lightweight distributed tracing.
+ *
+ * Trace context travels between processes in the W3C `traceparent` gRPC
+ * metadata entry. Each process records its spans in memory and writes them
+ * to a Chrome trace-event JSON file on flush, which chrome://tracing and
+ * Perfetto load directly. Timestamps are wall-clock microseconds, so files
+ * from processes on the same host line up when loaded together.
+ *
+ * With tracing disabled spans record nothing but still pass the incoming
+ * context through, so a process without a trace file doesn't break the
+ * trace for the processes downstream of it.
+ */
+
+namespace crackstore {
+
+struct TraceContext {
+    uint64_t trace_id_high = 0;
+    uint64_t trace_id_low = 0;
+    uint64_t span_id = 0;
+    bool sampled = true;
+
+    bool valid() const { return trace_id_high != 0 || trace_id_low != 0; }
+
+    std::string trace_id() const {
+        char buf[33];
+        std::snprintf(buf, sizeof(buf), "%016llx%016llx",
+                      static_cast<unsigned long long>(trace_id_high),
+                      static_cast<unsigned long long>(trace_id_low));
+        return buf;
+    }
+
+    // version-traceid-spanid-flags, e.g. 00-4bf9...4736-00f0...02b7-01
+    std::string to_traceparent() const {
+        char buf[56];
+        std::snprintf(buf, sizeof(buf), "00-%016llx%016llx-%016llx-%02x",
+                      static_cast<unsigned long long>(trace_id_high),
+                      static_cast<unsigned long long>(trace_id_low),
+                      static_cast<unsigned long long>(span_id),
+                      sampled ? 1 : 0);
+        return buf;
+    }
+
+    // Returns an invalid context if the header is malformed
+    static TraceContext from_traceparent(const std::string& header) {
+        TraceContext context;
+        if (header.size() != 55 || header[2] != '-' || header[35] != '-' || header[52] != '-') {
+            return context;
+        }
+
+        auto hex = [&](size_t offset, size_t len, uint64_t& out) {
+            out = 0;
+            for (size_t i = offset; i < offset + len; ++i) {
+                char c = header[i];
+                int digit;
+                if (c >= '0' && c <= '9') digit = c - '0';
+                else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+                else return false;
+                out = (out << 4) | digit;
+            }
+            return true;
+        };
+
+        uint64_t version, flags;
+        TraceContext parsed;
+        if (!hex(0, 2, version) || version == 0xff ||
+            !hex(3, 16, parsed.trace_id_high) || !hex(19, 16, parsed.trace_id_low) ||
+            !hex(36, 16, parsed.span_id) || !hex(53, 2, flags) ||
+            !parsed.valid() || parsed.span_id == 0) {
+            return context;
+        }
+        parsed.sampled = (flags & 1) != 0;
+        return parsed;
+    }
+};
+
+
+/**
+ * Process-wide span sink. Disabled until enable() is called with an
+ * output path; flush() rewrites the file with every span recorded so far.
+ */
+class Tracer {
+public:
+    static constexpr size_t kMaxSpans = 1 << 20;  // Later spans are dropped
+
+    struct SpanRecord {
+        std::string name;
+        long long start_us = 0;
+        long long duration_us = 0;
+        int tid = 0;
+        TraceContext context;
+        uint64_t parent_span_id = 0;
+        std::vector<std::pair<std::string, std::string>> args;
+    };
+
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void enable(const std::string& path, const std::string& process_name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path_ = path;
+        process_name_ = process_name;
+        enabled_ = true;
+    }
+
+    bool enabled() const { return enabled_; }
+
+    void record(SpanRecord&& span) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (spans_.size() >= kMaxSpans) {
+            dropped_++;
+            return;
+        }
+        spans_.push_back(std::move(span));
+    }
+
+    // Wall-clock microseconds for a steady_clock time point
+    long long to_wall_us(std::chrono::steady_clock::time_point t) const {
+        return wall_offset_us_ +
+            std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+    }
+
+    uint64_t random_id() {
+        thread_local std::mt19937_64 rng(std::random_device{}());
+        uint64_t id;
+        do { id = rng(); } while (id == 0);
+        return id;
+    }
+
+    // Small stable id for the calling thread, used as the trace "tid"
+    int thread_id() {
+        thread_local int tid = next_tid_++;
+        return tid;
+    }
+
+    bool flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!enabled_) return true;
+
+        std::ofstream out(path_);
+        if (!out) return false;
+
+        int pid = static_cast<int>(::getpid());
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"args\":{\"name\":\"" << escape(process_name_) << "\"}}";
+
+        for (const SpanRecord& span : spans_) {
+            out << ",\n{\"name\":\"" << escape(span.name) << "\",\"cat\":\"crackstore\",\"ph\":\"X\""
+                << ",\"ts\":" << span.start_us << ",\"dur\":" << span.duration_us
+                << ",\"pid\":" << pid << ",\"tid\":" << span.tid
+                << ",\"args\":{\"trace_id\":\"" << span.context.trace_id() << "\""
+                << ",\"span_id\":\"" << hex64(span.context.span_id) << "\"";
+            if (span.parent_span_id != 0) {
+                out << ",\"parent_span_id\":\"" << hex64(span.parent_span_id) << "\"";
+            }
+            for (const auto& [key, value] : span.args) {
+                out << ",\"" << escape(key) << "\":\"" << escape(value) << "\"";
+            }
+            out << "}}";
+        }
+        out << "\n]}\n";
+
+        if (dropped_ > 0) {
+            std::fprintf(stderr, "[Tracer] %zu spans dropped (limit %zu)\n", dropped_, kMaxSpans);
+        }
+        return static_cast<bool>(out);
+    }
+
+private:
+    Tracer() {
+        auto wall = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        auto steady = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        wall_offset_us_ = wall - steady;
+    }
+
+    static std::string hex64(uint64_t v) {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+        return buf;
+    }
+
+    static std::string escape(const std::string& s) {
+        std::string out;
+        out.reserve(s.size());
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[7];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    std::mutex mutex_;
+    std::atomic<bool> enabled_{false};
+    std::atomic<int> next_tid_{1};
+    std::string path_;
+    std::string process_name_;
+    long long wall_offset_us_ = 0;
+    std::vector<SpanRecord> spans_;
+    size_t dropped_ = 0;
+};
+
+
+/**
+ * RAII span. A child of `parent` when it is valid, otherwise the root of a
+ * new trace. Ends when destroyed unless end() was called earlier.
+ */
+class Span {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Span(const std::string& name, const TraceContext& parent, Clock::time_point start = Clock::now())
+        : tracer_(Tracer::instance()), context_(parent) {
+        if (!tracer_.enabled() || (parent.valid() && !parent.sampled)) return;
+
+        recording_ = true;
+        record_.name = name;
+        record_.start_us = tracer_.to_wall_us(start);
+        record_.tid = tracer_.thread_id();
+        record_.parent_span_id = parent.valid() ? parent.span_id : 0;
+        if (!parent.valid()) {
+            context_.trace_id_high = tracer_.random_id();
+            context_.trace_id_low = tracer_.random_id();
+            context_.sampled = true;
+        }
+        context_.span_id = tracer_.random_id();
+        record_.context = context_;
+    }
+
+    ~Span() { end(); }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    void end(Clock::time_point finish = Clock::now()) {
+        if (!recording_) return;
+        recording_ = false;
+        record_.duration_us = std::max(0LL, tracer_.to_wall_us(finish) - record_.start_us);
+        tracer_.record(std::move(record_));
+    }
+
+    void set_arg(const std::string& key, const std::string& value) {
+        if (recording_) record_.args.emplace_back(key, value);
+    }
+
+    void set_arg(const std::string& key, long long value) {
+        if (recording_) record_.args.emplace_back(key, std::to_string(value));
+    }
+
+    // Context to hand to children and to downstream RPCs
+    const TraceContext& context() const { return context_; }
+
+private:
+    Tracer& tracer_;
+    TraceContext context_;
+    Tracer::SpanRecord record_;
+    bool recording_ = false;
+};
+
+
+/**
+ * Concatenate trace files written by Tracer::flush() (one event per line)
+ * so spans from the client, coordinator and nodes open as one timeline.
+ */
+inline bool merge_trace_files(const std::string& output, const std::vector<std::string>& inputs) {
+    std::vector<std::string> events;
+    for (const std::string& path : inputs) {
+        std::ifstream in(path);
+        if (!in) return false;
+        
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == ',') line.pop_back();
+            if (line.empty() || line[0] != '{' || line.compare(0, 18, "{\"displayTimeUnit\"") == 0) continue;
+            events.push_back(line);
+        }
+    }
+    
+    std::ofstream out(output);
+    if (!out) return false;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        out << (i == 0 ? "" : ",\n") << events[i];
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+
+constexpr const char* kTraceparentKey = "traceparent";
+
+inline void inject_trace_context(grpc::ClientContext& client_context, const TraceContext& context) {
+    if (context.valid()) {
+        client_context.AddMetadata(kTraceparentKey, context.to_traceparent());
+    }
+}
+
+inline TraceContext extract_trace_context(const grpc::ServerContext& server_context) {
+    const auto& metadata = server_context.client_metadata();
+    auto it = metadata.find(kTraceparentKey);
+    if (it == metadata.end()) return TraceContext();
+    return TraceContext::from_traceparent(std::string(it->second.data(), it->second.size()));
+}
+
+}
+
+#endif
@@ -0,0 +1,679 @@
+#ifndef COORDINATOR_SERVICE_H
+#define COORDINATOR_SERVICE_H
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <condition_variable>
+#include <cmath>
+#include <climits>
+
+#include <grpcpp/grpcpp.h>
+#include "crackstore.grpc.pb.h"
+#include "cost_model.h"
+#include "partitioner.h"
+#include "tracing.h"
+#include "channel_pool.h"
+
+/**
+ * Coordinator service: node registry, heartbeats and distributed range
+ * queries. Hosted by the coordinator binary and by in-process clusters.
+ */
+
+namespace crackstore {
+
+using grpc::Channel;
+using grpc::ClientContext;
+using grpc::ServerContext;
+using grpc::Status;
+
+
+// Per-node deadline for a batch: generous multiple of the estimated cost,
+// clamped so a stale or missing estimate never makes a node look dead
+constexpr auto kMinNodeDeadline = std::chrono::seconds(2);
+constexpr auto kMaxNodeDeadline = std::chrono::seconds(30);
+constexpr double kDeadlineSlack = 10.0;
+constexpr double kCostSmoothing = 0.2;    // EWMA weight of a new ns/tuple sample
+
+
+struct NodeInfo {
+    std::string node_id;
+    std::string address;
+    int port;
+    bool is_healthy;
+    std::chrono::steady_clock::time_point last_heartbeat;
+    std::vector<std::unique_ptr<StorageService::Stub>> stubs;  // One per subchannel
+    size_t next_stub = 0;
+    
+    // Successive RPCs rotate over the node's subchannels. Caller must hold mutex_
+    StorageService::Stub& stub() { return *stubs[next_stub++ % stubs.size()]; }
+    std::map<std::string, CrackSummary> columns;  // Latest crack summaries, from heartbeats
+    double ns_per_tuple = 0.0;                    // Learned partitioning cost, 0 = unknown
+};
+
+
+
+class CoordinatorServiceImpl final : public CoordinatorService::Service {
+public:
+    explicit CoordinatorServiceImpl(std::chrono::microseconds coalesce_window = std::chrono::microseconds(0),
+                                    const ChannelOptions& channel_options = ChannelOptions())
+        : channel_pool_(channel_options), coalesce_window_(coalesce_window) {
+        std::cout << "[Coordinator] Service initialized (coalescing window: "
+                  << coalesce_window_.count() << "us, "
+                  << channel_pool_.options().subchannels << " subchannels per node)\n";
+    }
+
+    
+    Status RegisterNode(ServerContext* context,
+                        const RegisterNodeRequest* request,
+                        RegisterNodeResponse* response) override {
+        
+        // Channels are pooled, so a node re-registering reuses its connections.
+        // The pool hands out the target's subchannels in turn
+        std::string target = request->address() + ":" + std::to_string(request->port());
+        std::vector<std::shared_ptr<Channel>> channels;
+        for (int i = 0; i < channel_pool_.options().subchannels; ++i) {
+            channels.push_back(channel_pool_.Get(target));
+        }
+        std::string node_id = AddNode(request->address(), request->port(), channels);
+        
+        response->set_success(true);
+        response->set_assigned_node_id(node_id);
+        response->set_message("Registered successfully");
+        
+        return Status::OK;
+    }
+
+    /**
+     * Register a node reachable through an existing channel, e.g. an
+     * in-process channel to a node hosted in the same binary.
+     */
+    std::string RegisterLocalNode(const std::string& address, int port,
+                                  std::shared_ptr<Channel> channel) {
+        return AddNode(address, port, {std::move(channel)});
+    }
+
+    // Per-batch and per-node log lines; off for benchmarks
+    void set_query_logging(bool enabled) { log_queries_ = enabled; }
+
+    Status Heartbeat(ServerContext* context,
+                     const HeartbeatRequest* request,
+                     HeartbeatResponse* response) override {
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        const std::string& node_id = request->node_id();
+        
+        auto it = nodes_.find(node_id);
+        if (it != nodes_.end()) {
+            it->second. last_heartbeat = std::chrono::steady_clock::now();
+            it->second.is_healthy = true;
+            
+            std::map<std::string, CrackSummary> columns;
+            for (const auto& column : request->columns()) {
+                CrackSummary& summary = columns[column.column_name()];
+                summary.total_rows = column.total_rows();
+                summary.min_value = column.min_value();
+                summary.max_value = column.max_value();
+                summary.total_cracks = column.total_cracks();
+                for (const auto& boundary : column.boundaries()) {
+                    summary.boundaries.emplace_back(boundary.value(), boundary.position());
+                }
+                summary.piece_size_histogram.assign(
+                    column.piece_size_histogram().begin(), column.piece_size_histogram().end());
+            }
+            it->second.columns = std::move(columns);
+            
+            response->set_acknowledged(true);
+        } else {
+            response->set_acknowledged(false);
+        }
+        
+        return Status::OK;
+    }
+
+    
+    Status LoadData(ServerContext* context,
+                    const DistributedLoadRequest* request,
+                    DistributedLoadResponse* response) override {
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        std::cout << "[Coordinator] LoadData request for column: " 
+                  << request->column_name() << "\n";
+        
+        // Get list of healthy nodes
+        std::vector<std::string> healthy_nodes;
+        for (const auto& [id, node] : nodes_) {
+            if (node.is_healthy) {
+                healthy_nodes. push_back(id);
+            }
+        }
+        
+        if (healthy_nodes.empty()) {
+            response->set_success(false);
+            response->set_message("No healthy nodes available");
+            return Status::OK;
+        }
+        
+        // For now, just report success - actual loading done by client directly
+        response->set_success(true);
+        response->set_nodes_used(healthy_nodes. size());
+        for (const auto& id : healthy_nodes) {
+            response->add_node_ids(id);
+        }
+        response->set_message("Ready to load data to " + std::to_string(healthy_nodes.size()) + " nodes");
+        
+        return Status::OK;
+    }
+
+    
+    // Concurrent queries are coalesced: the first caller to find no batch in
+    // flight leads the next one, waits out the coalescing window, and fans out
+    // every query queued by then. Callers arriving meanwhile wait for it.
+    Status RangeQuery(ServerContext* context,
+                      const DistributedRangeQueryRequest* request,
+                      DistributedRangeQueryResponse* response) override {
+        
+        Span span("coordinator.RangeQuery", extract_trace_context(*context));
+        span.set_arg("column", request->column_name());
+        span.set_arg("low", request->low());
+        span.set_arg("high", request->high());
+        
+        PendingQuery query;
+        query.request = request;
+        query.response = response;
+        query.enqueued = std::chrono::steady_clock::now();
+        query.trace = span.context();
+        
+        std::unique_lock<std::mutex> lock(batch_mutex_);
+        pending_.push_back(&query);
+        
+        while (!query.done) {
+            if (batch_in_flight_) {
+                batch_cv_.wait(lock);
+                continue;
+            }
+            
+            batch_in_flight_ = true;
+            if (coalesce_window_.count() > 0) {
+                lock.unlock();
+                std::this_thread::sleep_for(coalesce_window_);
+                lock.lock();
+            }
+            
+            std::vector<PendingQuery*> batch;
+            batch.swap(pending_);
+            
+            lock.unlock();
+            ExecuteBatch(batch);
+            lock.lock();
+            
+            for (PendingQuery* q : batch) {
+                q->done = true;
+            }
+            batch_in_flight_ = false;
+            batch_cv_.notify_all();
+        }
+        
+        return Status::OK;
+    }
+
+    /**
+     * Route each value to the node that owns it under the column's partition
+     * map. Without a map there is no owner, so the update is rejected rather
+     * than guessed at: a value queued on the wrong node would never be found
+     * by a delete, and would be skipped by pruned queries.
+     */
+    Status Update(ServerContext* context,
+                  const UpdateRequest* request,
+                  UpdateResponse* response) override {
+        
+        Span span("coordinator.Update", extract_trace_context(*context));
+        span.set_arg("column", request->column_name());
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto map_it = partition_maps_.find(request->column_name());
+        if (map_it == partition_maps_.end()) {
+            response->set_success(false);
+            response->set_error_message("No partition map for column " + request->column_name());
+            return Status::OK;
+        }
+        const PartitionMap& map = map_it->second;
+        std::vector<int> splitters(map.splitters().begin(), map.splitters().end());
+        
+        std::map<std::string, UpdateRequest> per_node;
+        auto route = [&](int value) -> UpdateRequest& {
+            UpdateRequest& node_request = per_node[map.node_ids(partition_of(splitters, value))];
+            node_request.set_column_name(request->column_name());
+            return node_request;
+        };
+        for (int value : request->inserts()) route(value).add_inserts(value);
+        for (int value : request->deletes()) route(value).add_deletes(value);
+        
+        response->set_success(true);
+        for (const auto& [node_id, node_request] : per_node) {
+            auto node_it = nodes_.find(node_id);
+            if (node_it == nodes_.end() || !node_it->second.is_healthy) {
+                response->set_success(false);
+                response->set_error_message("Owner " + node_id + " is unavailable");
+                continue;
+            }
+            
+            UpdateResponse node_response;
+            ClientContext client_context;
+            client_context.set_deadline(std::chrono::system_clock::now() + kMinNodeDeadline);
+            inject_trace_context(client_context, span.context());
+            Status status = node_it->second.stub().Update(&client_context, node_request, &node_response);
+            
+            if (!status.ok() || !node_response.success()) {
+                response->set_success(false);
+                response->set_error_message(node_id + ": " +
+                    (status.ok() ? node_response.error_message() : status.error_message()));
+                continue;
+            }
+            response->set_inserted(response->inserted() + node_response.inserted());
+            response->set_deleted(response->deleted() + node_response.deleted());
+            response->set_nodes_updated(response->nodes_updated() + 1);
+        }
+        
+        return Status::OK;
+    }
+
+    Status GetClusterStatus(ServerContext* context,
+                            const ClusterStatusRequest* request,
+                            ClusterStatusResponse* response) override {
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        int healthy_count = 0;
+        auto now = std::chrono::steady_clock::now();
+        
+        for (const auto& [id, node] : nodes_) {
+            auto* status = response->add_nodes();
+            status->set_node_id(id);
+            status->set_address(node.address);
+            status->set_port(node. port);
+            status->set_is_healthy(node.is_healthy);
+            for (const auto& [name, summary] : node.columns) {
+                status->add_columns(name);
+            }
+            
+            auto ms_since_heartbeat = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - node. last_heartbeat
+            ).count();
+            status->set_last_heartbeat_ms(ms_since_heartbeat);
+            
+            if (node. is_healthy) healthy_count++;
+        }
+        
+        response->set_total_nodes(nodes_.size());
+        response->set_healthy_nodes(healthy_count);
+        
+        std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+        auto* coalescing = response->mutable_coalescing();
+        coalescing->set_queries_received(coalescing_.queries_received);
+        coalescing->set_batches_dispatched(coalescing_.batches_dispatched);
+        coalescing->set_ranges_dispatched(coalescing_.ranges_dispatched);
+        if (coalescing_.batches_dispatched > 0) {
+            coalescing->set_coalescing_ratio(
+                static_cast<double>(coalescing_.queries_received) / coalescing_.batches_dispatched);
+        }
+        if (coalescing_.queries_received > 0) {
+            coalescing->set_avg_queue_time_ms(
+                coalescing_.total_queue_time_ms / coalescing_.queries_received);
+        }
+        coalescing->set_max_queue_time_ms(coalescing_.max_queue_time_ms);
+        
+        return Status::OK;
+    }
+
+    Status SetPartitionMap(ServerContext* context,
+                           const PartitionMap* request,
+                           StatusResponse* response) override {
+        
+        if (request->node_ids_size() == 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            partition_maps_.erase(request->column_name());
+            response->set_success(true);
+            response->set_message("Partition map cleared");
+            return Status::OK;
+        }
+        
+        bool ascending = std::is_sorted(request->splitters().begin(), request->splitters().end());
+        if (request->node_ids_size() != request->splitters_size() + 1 || !ascending) {
+            response->set_success(false);
+            response->set_message("Partition map needs ascending splitters and one more node than splitters");
+            return Status::OK;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        partition_maps_[request->column_name()] = *request;
+        
+        std::cout << "[Coordinator] Partition map for " << request->column_name() << ": "
+                  << request->node_ids_size() << " partitions\n";
+        
+        response->set_success(true);
+        response->set_message("OK");
+        return Status::OK;
+    }
+
+    Status GetPartitionMap(ServerContext* context,
+                           const PartitionMapRequest* request,
+                           PartitionMap* response) override {
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = partition_maps_.find(request->column_name());
+        if (it != partition_maps_.end()) {
+            *response = it->second;
+        } else {
+            response->set_column_name(request->column_name());
+        }
+        return Status::OK;
+    }
+
+    std::vector<std::pair<std::string, int>> GetNodeAddresses() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::pair<std::string, int>> addresses;
+        for (const auto& [id, node] : nodes_) {
+            if (node.is_healthy) {
+                addresses.emplace_back(node.address, node. port);
+            }
+        }
+        return addresses;
+    }
+
+private:
+    std::string AddNode(const std::string& address, int port,
+                        const std::vector<std::shared_ptr<Channel>>& channels) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        std::string node_id = "node-" + std::to_string(next_node_id_++);
+        
+        std::cout << "[Coordinator] Registering node: " << node_id 
+                  << " at " << address << ":" << port << "\n";
+        
+        NodeInfo node;
+        node.node_id = node_id;
+        node.address = address;
+        node.port = port;
+        node.is_healthy = true;
+        node.last_heartbeat = std::chrono::steady_clock::now();
+        for (const auto& channel : channels) {
+            node.stubs.push_back(StorageService::NewStub(channel));
+        }
+        
+        nodes_[node_id] = std::move(node);
+        
+        std::cout << "[Coordinator] Node " << node_id << " registered.  Total nodes: "
+                  << nodes_. size() << "\n";
+        
+        return node_id;
+    }
+
+    // False only when the column's partition map rules the node out for the
+    // range. Caller must hold mutex_
+    bool NodeMayHold(const std::string& node_id, const RangeQueryRequest& query) const {
+        auto it = partition_maps_.find(query.column_name());
+        if (it == partition_maps_.end()) return true;
+        
+        const PartitionMap& map = it->second;
+        for (int i = 0; i < map.node_ids_size(); ++i) {
+            if (map.node_ids(i) != node_id) continue;
+            long long lo = (i == 0) ? LLONG_MIN : map.splitters(i - 1);
+            long long hi = (i == map.splitters_size()) ? LLONG_MAX : map.splitters(i);
+            if (query.low() < hi && query.high() > lo && query.low() < query.high()) return true;
+        }
+        return false;
+    }
+
+    struct PendingQuery {
+        const DistributedRangeQueryRequest* request = nullptr;
+        DistributedRangeQueryResponse* response = nullptr;
+        std::chrono::steady_clock::time_point enqueued;
+        TraceContext trace;
+        bool done = false;
+    };
+
+    struct CoalescingCounters {
+        long long queries_received = 0;
+        long long batches_dispatched = 0;
+        long long ranges_dispatched = 0;
+        double total_queue_time_ms = 0.0;
+        double max_queue_time_ms = 0.0;
+    };
+
+    std::map<std::string, NodeInfo> nodes_;
+    std::mutex mutex_;
+    ChannelPool channel_pool_;
+    std::atomic<bool> log_queries_{true};
+    std::map<std::string, PartitionMap> partition_maps_;    // By column, set by loaders
+    int next_node_id_ = 1;
+
+    std::chrono::microseconds coalesce_window_;
+    std::vector<PendingQuery*> pending_;    // Queries waiting for the next batch
+    bool batch_in_flight_ = false;
+    std::mutex batch_mutex_;                // Guards pending_, batch_in_flight_, coalescing_
+    std::condition_variable batch_cv_;
+    CoalescingCounters coalescing_;
+
+    // Fold a node-reported query into its ns/tuple estimate. Caller must hold mutex_
+    void RecordQueryCost(NodeInfo& node, const QueryStats& stats) {
+        if (stats.tuples_touched() <= 0 || stats.query_time_ms() <= 0.0) return;
+        double sample = stats.query_time_ms() * 1e6 / stats.tuples_touched();
+        node.ns_per_tuple = node.ns_per_tuple > 0.0
+            ? (1.0 - kCostSmoothing) * node.ns_per_tuple + kCostSmoothing * sample
+            : sample;
+    }
+
+    // Fan out one batch: identical ranges are deduplicated and each healthy
+    // node receives a single BatchRangeQuery carrying every distinct range.
+    // Crack summaries from heartbeats predict each node's result size and
+    // work, which set its deadline and are reported next to the actuals.
+    // Ranges a column's partition map places elsewhere are not sent; a
+    // range fails if a node the map places it on is down or does not answer.
+    void ExecuteBatch(const std::vector<PendingQuery*>& batch) {
+        auto dispatch_time = std::chrono::steady_clock::now();
+        
+        // The fan-out is shared by the whole batch; it is traced under the
+        // leader's query and every member records its own queue time
+        Span batch_span("coordinator.batch", batch.front()->trace, dispatch_time);
+        batch_span.set_arg("batch_size", static_cast<long long>(batch.size()));
+        for (PendingQuery* q : batch) {
+            Span queue_span("coordinator.queue", q->trace, q->enqueued);
+            queue_span.set_arg("batch_trace_id", batch_span.context().trace_id());
+            queue_span.end(dispatch_time);
+        }
+        
+        std::map<std::tuple<std::string, int, int>, int> range_slots;
+        std::vector<int> slot_of(batch.size());
+        BatchRangeQueryRequest node_request;
+        
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const DistributedRangeQueryRequest* request = batch[i]->request;
+            auto key = std::make_tuple(request->column_name(), request->low(), request->high());
+            auto it = range_slots.find(key);
+            if (it == range_slots.end()) {
+                it = range_slots.emplace(key, node_request.queries_size()).first;
+                auto* query = node_request.add_queries();
+                query->set_column_name(request->column_name());
+                query->set_low(request->low());
+                query->set_high(request->high());
+            }
+            slot_of[i] = it->second;
+        }
+        
+        int num_ranges = node_request.queries_size();
+        batch_span.set_arg("ranges", num_ranges);
+        std::vector<DistributedRangeQueryResponse> partials(num_ranges);
+        std::vector<std::string> missing(num_ranges);   // An owner that did not answer, per range
+        
+        if (log_queries_) {
+            std::cout << "[Coordinator] Batch of " << batch.size() << " queries ("
+                      << num_ranges << " distinct ranges)\n";
+        }
+        
+        {
+            Span lock_wait("coordinator.lock_wait", batch_span.context());
+            std::lock_guard<std::mutex> lock(mutex_);
+            lock_wait.end();
+            
+            for (auto& [node_id, node] : nodes_) {
+                // Ranges this node can hold rows for, according to the partition maps
+                std::vector<int> slots;
+                BatchRangeQueryRequest pruned_request;
+                for (int j = 0; j < num_ranges; ++j) {
+                    const RangeQueryRequest& query = node_request.queries(j);
+                    if (NodeMayHold(node_id, query)) {
+                        slots.push_back(j);
+                        *pruned_request.add_queries() = query;
+                    } else {
+                        partials[j].set_nodes_pruned(partials[j].nodes_pruned() + 1);
+                    }
+                }
+                if (slots.empty()) continue;
+                
+                // A partition-map owner that is down fails its ranges, or
+                // the other nodes' pruning would make them look empty
+                auto mark_missing = [&](int slot) {
+                    if (missing[slot].empty() &&
+                        partition_maps_.count(node_request.queries(slot).column_name())) {
+                        missing[slot] = node_id;
+                    }
+                };
+                if (!node.is_healthy) {
+                    for (int slot : slots) mark_missing(slot);
+                    continue;
+                }
+                int node_ranges = static_cast<int>(slots.size());
+                
+                std::vector<QueryCostEstimate> estimates(node_ranges);
+                double estimated_touched = 0.0;
+                bool have_estimates = true;
+                for (int k = 0; k < node_ranges; ++k) {
+                    const RangeQueryRequest& query = pruned_request.queries(k);
+                    auto summary = node.columns.find(query.column_name());
+                    if (summary == node.columns.end()) {
+                        have_estimates = false;
+                        continue;
+                    }
+                    estimates[k] = estimate_query_cost(summary->second, query.low(), query.high());
+                    estimated_touched += estimates[k].expected_touched;
+                }
+                
+                auto deadline = std::chrono::duration_cast<std::chrono::milliseconds>(kMaxNodeDeadline);
+                double estimated_ms = estimated_touched * node.ns_per_tuple / 1e6;
+                if (have_estimates && node.ns_per_tuple > 0.0) {
+                    auto scaled = std::chrono::milliseconds(
+                        static_cast<long long>(kDeadlineSlack * estimated_ms));
+                    deadline = std::clamp<std::chrono::milliseconds>(
+                        scaled, kMinNodeDeadline, kMaxNodeDeadline);
+                }
+                
+                Span rpc_span("coordinator.node_rpc", batch_span.context());
+                rpc_span.set_arg("node_id", node_id);
+                rpc_span.set_arg("ranges", node_ranges);
+                rpc_span.set_arg("deadline_ms", static_cast<long long>(deadline.count()));
+                
+                BatchRangeQueryResponse node_response;
+                ClientContext client_context;
+                client_context.set_deadline(std::chrono::system_clock::now() + deadline);
+                inject_trace_context(client_context, rpc_span.context());
+                
+                Status status = node.stub().BatchRangeQuery(&client_context, pruned_request, &node_response);
+                rpc_span.end();
+                
+                if (!status.ok() || node_response.results_size() != node_ranges) {
+                    std::cerr << "[Coordinator]   " << node_id << ": FAILED - " 
+                              << status.error_message() << "\n";
+                    node.is_healthy = false;
+                    for (int slot : slots) mark_missing(slot);
+                    continue;
+                }
+                
+                for (int k = 0; k < node_ranges; ++k) {
+                    const RangeQueryResponse& node_result = node_response.results(k);
+                    if (!node_result.success()) {
+                        std::cerr << "[Coordinator]   " << node_id << ": "
+                                  << node_result.error_message() << "\n";
+                        mark_missing(slots[k]);
+                        continue;
+                    }
+                    
+                    DistributedRangeQueryResponse& partial = partials[slots[k]];
+                    partial.set_total_count(partial.total_count() + node_result.count());
+                    partial.set_nodes_queried(partial.nodes_queried() + 1);
+                    
+                    auto* result = partial.add_node_results();
+                    result->set_node_id(node_id);
+                    result->set_count(node_result.count());
+                    result->set_estimated_count(std::llround(estimates[k].expected_count));
+                    result->set_estimated_touched(std::llround(estimates[k].expected_touched));
+                    partial.set_estimated_total_count(
+                        partial.estimated_total_count() + result->estimated_count());
+                    
+                    if (node_result.has_stats()) {
+                        *result->mutable_stats() = node_result.stats();
+                        RecordQueryCost(node, node_result.stats());
+                    }
+                }
+                
+                if (log_queries_) {
+                    std::cout << "[Coordinator]   " << node_id << ": answered "
+                              << node_ranges << " ranges (estimated " << estimated_ms
+                              << "ms, deadline " << deadline.count() << "ms)\n";
+                }
+            }
+        }
+        
+        auto end_time = std::chrono::steady_clock::now();
+        double max_queue_ms = 0.0;
+        double sum_queue_ms = 0.0;
+        
+        for (size_t i = 0; i < batch.size(); ++i) {
+            DistributedRangeQueryResponse* response = batch[i]->response;
+            *response = partials[slot_of[i]];
+            
+            double queue_ms = std::chrono::duration<double, std::milli>(
+                dispatch_time - batch[i]->enqueued).count();
+            double total_ms = std::chrono::duration<double, std::milli>(
+                end_time - batch[i]->enqueued).count();
+            
+            response->set_total_time_ms(total_ms);
+            response->set_queue_time_ms(queue_ms);
+            response->set_batch_size(static_cast<int>(batch.size()));
+            // A query every node was pruned from is a valid empty result
+            const std::string& owner = missing[slot_of[i]];
+            bool answered = response->nodes_queried() + response->nodes_pruned() > 0;
+            response->set_success(answered && owner.empty());
+            if (!owner.empty()) {
+                response->set_error_message("Owner " + owner + " of part of the range did not respond");
+            } else if (!answered) {
+                response->set_error_message("No nodes responded");
+            }
+            
+            sum_queue_ms += queue_ms;
+            max_queue_ms = std::max(max_queue_ms, queue_ms);
+        }
+        
+        std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+        coalescing_.queries_received += batch.size();
+        coalescing_.batches_dispatched++;
+        coalescing_.ranges_dispatched += num_ranges;
+        coalescing_.total_queue_time_ms += sum_queue_ms;
+        coalescing_.max_queue_time_ms = std::max(coalescing_.max_queue_time_ms, max_queue_ms);
+    }
+};
+
+}
+
+#endif
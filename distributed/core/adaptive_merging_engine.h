@@ -0,0 +1,496 @@
+#ifndef ADAPTIVE_MERGING_ENGINE_H
+#define ADAPTIVE_MERGING_ENGINE_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iterator>
+
+#include "column_engine.h"
+#include "cracking_engine.h"
+
+/**
+ * AdaptiveMergingEngine - Hybrid crack-sort adaptive indexing
+ *
+ * Based on the hybrid algorithms from:
+ * "Merging What's Cracked, Cracking What's Merged: Adaptive Indexing in Main-Memory Column-Stores"
+ * Stratos Idreos, Stefan Manegold, Harumi Kuno, Goetz Graefe (VLDB 2011)
+ *
+ * The column starts as initial partitions. A query range no final
+ * partition covers yet is cracked out of every initial partition, and the
+ * values are sorted into a new final partition; from then on the range is
+ * answered from final partitions alone. Counts and views are binary
+ * searches in the final partitions the range touches.
+ *
+ * This is src/ai.h's crack-sort variant written again, self-contained, as
+ * CrackingEngine is for src/crack.cpp. ai.h cannot hold a storage node's
+ * columns: its stochastic switch and its counters are process globals
+ * shared by every instance, deleted tuples leave -1 in place (so values
+ * must be non-negative), and a delete of a value it does not hold fails an
+ * assertion, where clients send arbitrary updates here. What ai.h gained
+ * for the harness (parallel extraction, background sorting of the initial
+ * partitions, the final partitions' arena) is not carried over; a change to
+ * the algorithm itself belongs in both.
+ */
+
+namespace crackstore {
+
+
+class AdaptiveMergingEngine : public ColumnEngine {
+public:
+    static constexpr int kDefaultPartitionSize = 1 << 20;
+
+    /**
+     * Construct an AdaptiveMergingEngine with a copy of the provided data.
+     *
+     * @param data            Pointer to integer array
+     * @param size            Number of elements in array
+     * @param partition_size  Rows per initial partition
+     */
+    AdaptiveMergingEngine(const int* data, int size, int partition_size = kDefaultPartitionSize) {
+        partition_size = std::max(partition_size, 1);
+        for (int i = 0; i < size; i += partition_size) {
+            initial_.emplace_back();
+            initial_.back().values.assign(data + i, data + std::min(size, i + partition_size));
+        }
+        initial_rows_ = size;
+
+        if (size > 0) {
+            min_value_ = *std::min_element(data, data + size);
+            max_value_ = *std::max_element(data, data + size);
+        }
+
+        stats_.reset();
+    }
+
+    // Disable copy (engine owns the column)
+    AdaptiveMergingEngine(const AdaptiveMergingEngine&) = delete;
+    AdaptiveMergingEngine& operator=(const AdaptiveMergingEngine&) = delete;
+
+    AdaptiveMergingEngine(AdaptiveMergingEngine&&) = default;
+    AdaptiveMergingEngine& operator=(AdaptiveMergingEngine&&) = default;
+
+    /**
+     * @param low   Lower bound (inclusive)
+     * @param high  Upper bound (exclusive)
+     * @return      Count of elements where low <= element < high
+     */
+    int range_query(int low, int high) override {
+        return execute(low, high, nullptr);
+    }
+
+    /**
+     * One run per final partition the range touches, in value order.
+     */
+    std::vector<ValueRun> range_view(int low, int high) override {
+        std::vector<ValueRun> runs;
+        execute(low, high, &runs);
+        return runs;
+    }
+
+    /**
+     * Queue an insert operation. It is merged into the final partition that
+     * covers the value during the next query on it.
+     */
+    void insert(int value) override {
+        // Widen the domain now so summaries cover pending inserts
+        if (min_value_ > max_value_) {
+            min_value_ = max_value_ = value;
+        } else {
+            min_value_ = std::min(min_value_, value);
+            max_value_ = std::max(max_value_, value);
+        }
+
+        auto it = pending_deletes_.find(value);
+        if (it != pending_deletes_.end()) {
+            pending_deletes_.erase(it);
+        } else {
+            pending_inserts_.insert(value);
+        }
+    }
+
+    /**
+     * Queue a remove operation, merged like an insert.
+     */
+    void remove(int value) override {
+        auto it = pending_inserts_.find(value);
+        if (it != pending_inserts_.end()) {
+            pending_inserts_.erase(it);
+        } else {
+            pending_deletes_.insert(value);
+        }
+    }
+
+    CrackingStats get_stats() const override {
+        return stats_;
+    }
+
+    void reset_stats() override {
+        stats_.reset();
+    }
+
+    /**
+     * Index points: cracks in the initial partitions plus final partitions.
+     */
+    int get_crack_count() const override {
+        return initial_cracks_ + static_cast<int>(final_.size());
+    }
+
+    int get_size() const override {
+        return initial_rows_ - extracted_rows_ + final_rows_;
+    }
+
+    int get_pending_inserts() const override {
+        return static_cast<int>(pending_inserts_.size());
+    }
+
+    int get_pending_deletes() const override {
+        return static_cast<int>(pending_deletes_.size());
+    }
+
+    int get_final_partition_count() const {
+        return static_cast<int>(final_.size());
+    }
+
+    /**
+     * Summarize the index for cost-based routing. Boundaries are the final
+     * partitions' edges, where every initial partition has a crack, and
+     * values inside them, where the order is known; the histogram has the
+     * initial partitions' pieces still to be cracked, and each final
+     * partition value as a piece of one, since a sorted run costs a search.
+     *
+     * @param max_boundaries  Upper bound on the boundaries reported
+     */
+    CrackSummary summarize(int max_boundaries) const override {
+        CrackSummary summary;
+        summary.total_rows = get_size() + static_cast<int>(pending_inserts_.size());
+        summary.min_value = min_value_;
+        summary.max_value = max_value_;
+
+        std::vector<std::pair<int, int>> points;
+        int step = std::max(1, final_rows_ / std::max(1, max_boundaries));
+        int merged_below = 0;    // rows merges added to the final partitions below
+        for (auto it = final_.begin(); it != final_.end(); ++it) {
+            const std::vector<int>& values = it->second.values;
+            int rank = initial_rank(it->first) + merged_below;
+            if (points.empty() || points.back().first < it->first) {
+                points.emplace_back(it->first, rank);
+            }
+            for (int j = step; j < static_cast<int>(values.size()); j += step) {
+                if (values[j] <= points.back().first) continue;
+                int below = static_cast<int>(std::lower_bound(values.begin(), values.end(), values[j]) - values.begin());
+                points.emplace_back(values[j], rank + below);
+            }
+            merged_below += static_cast<int>(values.size()) - it->second.extracted;
+
+            auto next = std::next(it);
+            if (next == final_.end() || next->first != it->second.high) {
+                points.emplace_back(it->second.high, initial_rank(it->second.high) + merged_below);
+            }
+            add_piece_to_histogram(summary.piece_size_histogram, 1, static_cast<int>(values.size()));
+        }
+        summary.total_cracks = static_cast<int>(points.size());
+
+        int stride = 1;
+        if (max_boundaries > 0 && summary.total_cracks > max_boundaries) {
+            stride = (summary.total_cracks + max_boundaries - 1) / max_boundaries;
+        }
+        for (int i = 0; max_boundaries > 0 && i < summary.total_cracks; i += stride) {
+            summary.boundaries.push_back(points[i]);
+        }
+
+        for (const InitialPartition& part : initial_) {
+            int prev = 0;
+            bool dead = false;
+            for (const auto& [value, index] : part.cracks) {
+                if (!dead) add_piece_to_histogram(summary.piece_size_histogram, index.pos - prev, 1);
+                prev = index.pos;
+                dead = covered(value);
+            }
+            if (!dead) add_piece_to_histogram(summary.piece_size_histogram, static_cast<int>(part.values.size()) - prev, 1);
+        }
+
+        return summary;
+    }
+
+private:
+    /**
+     * An initial partition, cracked on the edges of every final partition.
+     * Extracted values stay in place, in the pieces between those cracks,
+     * until compaction drops them.
+     */
+    struct InitialPartition {
+        std::vector<int> values;
+        CrackMap cracks;          // holes unused
+    };
+
+    /**
+     * A final partition: all values in [low, high), sorted. Keyed by low.
+     */
+    struct FinalPartition {
+        int high = 0;
+        std::vector<int> values;
+        int extracted = 0;        // values the initial partitions still hold
+    };
+
+    std::vector<InitialPartition> initial_;
+    std::map<int, FinalPartition> final_;
+
+    std::multiset<int> pending_inserts_;  // Pending insert operations
+    std::multiset<int> pending_deletes_;  // Pending delete operations
+
+    CrackingStats stats_;         // Query statistics
+
+    int initial_rows_ = 0;        // Values in initial partitions, extracted ones included
+    int extracted_rows_ = 0;      // Of those, values already in final partitions
+    int final_rows_ = 0;          // Values in final partitions
+    int initial_cracks_ = 0;      // Cracks over all initial partitions
+
+    int min_value_ = 0;           // Smallest value ever held (widened by inserts)
+    int max_value_ = -1;          // Largest value ever held (widened by inserts)
+
+    static void add_piece_to_histogram(std::vector<int>& histogram, int piece_size, int pieces) {
+        if (piece_size <= 0 || pieces <= 0) return;
+        int k = 0;
+        while ((piece_size >> (k + 1)) > 0) ++k;
+        if (static_cast<int>(histogram.size()) <= k) histogram.resize(k + 1, 0);
+        histogram[k] += pieces;
+    }
+
+    int execute(int low, int high, std::vector<ValueRun>* runs) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+
+        stats_.last_tuples_touched = 0;
+        int initial_cracks = get_crack_count();
+
+        int result = 0;
+        if (low < high) {
+            cover(low, high);
+            merge_pending_updates(low, high);
+            result = collect(low, high, runs);
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        double elapsed_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+        stats_.last_cracks_created = get_crack_count() - initial_cracks;
+        stats_.last_query_time_ms = elapsed_ms;
+        stats_.last_result_count = result;
+
+        stats_.queries_executed++;
+        stats_.total_tuples_touched += stats_.last_tuples_touched;
+        stats_.total_cracks_created += stats_.last_cracks_created;
+        stats_.total_query_time_ms += elapsed_ms;
+
+        // The views point into the final partitions only, so compacting the
+        // initial ones after the query leaves them valid
+        if (extracted_rows_ > 0 && 2 * extracted_rows_ >= initial_rows_) {
+            compact();
+        }
+
+        return result;
+    }
+
+    /** The first final partition that ends above v. */
+    std::map<int, FinalPartition>::iterator first_final(int v) {
+        auto it = final_.upper_bound(v);
+        if (it != final_.begin() && std::prev(it)->second.high > v) --it;
+        return it;
+    }
+
+    std::map<int, FinalPartition>::const_iterator first_final(int v) const {
+        return const_cast<AdaptiveMergingEngine*>(this)->first_final(v);
+    }
+
+    bool covered(int v) const {
+        auto it = first_final(v);
+        return it != final_.end() && it->first <= v;
+    }
+
+    /** Values of the initial partitions below v, extracted ones included; v is a final partition edge. */
+    int initial_rank(int v) const {
+        int rank = 0;
+        for (const InitialPartition& part : initial_) {
+            auto it = part.cracks.find(v);
+            assert(it != part.cracks.end());
+            rank += it->second.pos;
+        }
+        return rank;
+    }
+
+    /**
+     * Crack an initial partition on v, unless it already is.
+     *
+     * @return  Position where elements >= v begin
+     */
+    int crack_at(InitialPartition& part, int v) {
+        auto it = part.cracks.lower_bound(v);
+        if (it != part.cracks.end() && it->first == v) return it->second.pos;
+
+        int L = (it == part.cracks.begin()) ? 0 : std::prev(it)->second.pos;
+        int R = (it == part.cracks.end()) ? static_cast<int>(part.values.size()) : it->second.pos;
+        stats_.last_tuples_touched += R - L;
+
+        int pos = static_cast<int>(std::partition(part.values.begin() + L, part.values.begin() + R,
+                                                  [v](int x) { return x < v; }) - part.values.begin());
+        part.cracks.emplace_hint(it, v, CrackIndex{pos, 0, false});
+        initial_cracks_++;
+        return pos;
+    }
+
+    /**
+     * Move the values of [low, high) out of the initial partitions into a
+     * new final partition. Empty ranges get one too, so they are not cracked
+     * again.
+     */
+    void extract(int low, int high) {
+        FinalPartition part;
+        part.high = high;
+        for (InitialPartition& initial : initial_) {
+            int i1 = crack_at(initial, low);
+            int i2 = crack_at(initial, high);
+            part.values.insert(part.values.end(), initial.values.begin() + i1, initial.values.begin() + i2);
+        }
+        std::sort(part.values.begin(), part.values.end());
+        part.extracted = static_cast<int>(part.values.size());
+
+        stats_.last_tuples_touched += part.extracted;
+        extracted_rows_ += part.extracted;
+        final_rows_ += part.extracted;
+        final_.emplace(low, std::move(part));
+    }
+
+    /** Extract the parts of [low, high) no final partition covers. */
+    void cover(int low, int high) {
+        std::vector<std::pair<int, int>> gaps;
+        int x = low;
+        for (auto it = first_final(low); x < high; ++it) {
+            int y = (it == final_.end()) ? high : std::min(high, it->first);
+            if (x < y) gaps.emplace_back(x, y);
+            if (it == final_.end()) break;
+            x = std::max(x, it->second.high);
+        }
+        for (const auto& [gap_low, gap_high] : gaps) {
+            extract(gap_low, gap_high);
+        }
+    }
+
+    /**
+     * Merge the pending updates in [low, high) into the final partitions,
+     * which cover the range by now. Only the range's slice of a partition is
+     * rewritten, in place: deletes close it up (those of values it lacks are
+     * dropped), the values above move by the net change, and the inserts are
+     * merged in from the back.
+     */
+    void merge_pending_updates(int low, int high) {
+        for (auto it = first_final(low); it != final_.end() && it->first < high; ++it) {
+            int lo = std::max(low, it->first), hi = std::min(high, it->second.high);
+            auto ins_low = pending_inserts_.lower_bound(lo), ins_high = pending_inserts_.lower_bound(hi);
+            auto del_low = pending_deletes_.lower_bound(lo), del_high = pending_deletes_.lower_bound(hi);
+            if (ins_low == ins_high && del_low == del_high) continue;
+
+            std::vector<int>& values = it->second.values;
+            int size = static_cast<int>(values.size());
+            int b = static_cast<int>(std::lower_bound(values.begin(), values.end(), lo) - values.begin());
+            int e = static_cast<int>(std::lower_bound(values.begin() + b, values.end(), hi) - values.begin());
+
+            int kept = b;
+            auto del = del_low;
+            for (int i = b; i < e; ++i) {
+                while (del != del_high && *del < values[i]) ++del;
+                if (del != del_high && *del == values[i]) {
+                    ++del;
+                } else {
+                    values[kept++] = values[i];
+                }
+            }
+
+            int inserts = static_cast<int>(std::distance(ins_low, ins_high));
+            int end = kept + inserts;     // of the merged slice
+            int new_size = end + size - e;
+            if (end > e) {
+                values.resize(new_size);
+                std::move_backward(values.begin() + e, values.begin() + size, values.begin() + new_size);
+            } else if (end < e) {
+                std::move(values.begin() + e, values.begin() + size, values.begin() + end);
+                values.resize(new_size);
+            }
+            for (auto ins = ins_high; ins != ins_low; ) {
+                if (kept > b && values[kept - 1] > *std::prev(ins)) {
+                    values[--end] = values[--kept];
+                } else {
+                    values[--end] = *--ins;
+                }
+            }
+
+            stats_.last_tuples_touched += e - b + inserts;
+            final_rows_ += new_size - size;
+            pending_inserts_.erase(ins_low, ins_high);
+            pending_deletes_.erase(del_low, del_high);
+        }
+    }
+
+    /** Count, and optionally collect, the values of [low, high) in the final partitions. */
+    int collect(int low, int high, std::vector<ValueRun>* runs) const {
+        int count = 0;
+        for (auto it = first_final(low); it != final_.end() && it->first < high; ++it) {
+            const std::vector<int>& values = it->second.values;
+            auto b = (low <= it->first) ? values.begin() : std::lower_bound(values.begin(), values.end(), low);
+            auto e = (high >= it->second.high) ? values.end() : std::lower_bound(b, values.end(), high);
+            if (b == e) continue;
+            count += static_cast<int>(e - b);
+            if (runs) runs->push_back(ValueRun{&*b, static_cast<int>(e - b)});
+        }
+        return count;
+    }
+
+    /**
+     * Drop the extracted values from the initial partitions, once they are
+     * at least half of them. Cracks keep their values and move with the
+     * pieces, so the final partitions' edges stay cracks.
+     */
+    void compact() {
+        for (InitialPartition& part : initial_) {
+            std::vector<int>& values = part.values;
+            int out = 0, start = 0;
+            bool dead = false;    // the piece below the first crack is never covered
+            for (auto& [value, index] : part.cracks) {
+                if (!dead) out = keep(values, start, index.pos, out);
+                start = index.pos;
+                index.pos = out;
+                dead = covered(value);
+            }
+            if (!dead) out = keep(values, start, static_cast<int>(values.size()), out);
+            values.resize(out);
+        }
+
+        initial_.erase(std::remove_if(initial_.begin(), initial_.end(),
+                                      [](const InitialPartition& part) { return part.values.empty(); }),
+                       initial_.end());
+        initial_cracks_ = 0;
+        for (const InitialPartition& part : initial_) {
+            initial_cracks_ += static_cast<int>(part.cracks.size());
+        }
+
+        initial_rows_ -= extracted_rows_;
+        extracted_rows_ = 0;
+        for (auto& [low, part] : final_) {
+            part.extracted = 0;
+        }
+    }
+
+    /** Move values [from, to) down to out; returns the new end. */
+    static int keep(std::vector<int>& values, int from, int to, int out) {
+        if (out != from) {
+            std::copy(values.begin() + from, values.begin() + to, values.begin() + out);
+        }
+        return out + (to - from);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef COLUMN_ENGINE_H
+#define COLUMN_ENGINE_H
+
+#include <utility>
+#include <vector>
+
+/**
+ * The interface storage nodes hold a column through. engine_factory.h
+ * picks the engine behind it.
+ */
+
+namespace crackstore {
+
+
+struct CrackingStats {
+    // Cumulative statistics (lifetime of engine)
+    long long queries_executed = 0;
+    long long total_tuples_touched = 0;
+    long long total_cracks_created = 0;
+    double total_query_time_ms = 0.0;
+    
+    // Per-query statistics (reset after each query)
+    int last_tuples_touched = 0;
+    int last_cracks_created = 0;
+    double last_query_time_ms = 0.0;
+    int last_result_count = 0;
+    
+    // Stochastic cracking parameters of the last query (CrackingEngine)
+    int max_ncrack = 0;
+    int crack_at = 0;
+    
+    void reset() {
+        queries_executed = 0;
+        total_tuples_touched = 0;
+        total_cracks_created = 0;
+        total_query_time_ms = 0.0;
+        last_tuples_touched = 0;
+        last_cracks_created = 0;
+        last_query_time_ms = 0.0;
+        last_result_count = 0;
+        max_ncrack = 0;
+        crack_at = 0;
+    }
+};
+
+
+/**
+ * Compact description of a column's cracker index, small enough to ship
+ * with every heartbeat. Boundaries are (value, position) pairs: position is
+ * the number of elements smaller than value.
+ */
+struct CrackSummary {
+    int total_rows = 0;
+    int min_value = 0;
+    int max_value = -1;           // max < min means the column is empty
+    int total_cracks = 0;
+    std::vector<std::pair<int, int>> boundaries;  // Evenly spaced subset of crack points
+    std::vector<int> piece_size_histogram;        // [k] = pieces with size in [2^k, 2^(k+1))
+};
+
+
+/**
+ * A run of a range query's values, in place in the engine's storage. Valid
+ * until the next call that can modify the engine.
+ */
+struct ValueRun {
+    const int* values = nullptr;
+    int size = 0;
+};
+
+
+/**
+ * What storage nodes hold a column through, so a column can be cracked
+ * (CrackingEngine) or adaptively merged (AdaptiveMergingEngine).
+ */
+class ColumnEngine {
+public:
+    virtual ~ColumnEngine() = default;
+    
+    /** Count of values in [low, high), adapting the index to the range. */
+    virtual int range_query(int low, int high) = 0;
+    
+    /** The values in [low, high) as runs of the engine's storage, adapting like range_query. */
+    virtual std::vector<ValueRun> range_view(int low, int high) = 0;
+    
+    virtual void insert(int value) = 0;
+    virtual void remove(int value) = 0;
+    virtual CrackingStats get_stats() const = 0;
+    virtual void reset_stats() = 0;
+    virtual int get_crack_count() const = 0;
+    virtual int get_size() const = 0;
+    virtual int get_pending_inserts() const = 0;
+    virtual int get_pending_deletes() const = 0;
+    virtual CrackSummary summarize(int max_boundaries) const = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "column_engine.h"
+
+/**
+ * Query cost estimation from a CrackSummary.
+ *
+ * The cracker index records, for each crack value v, how many elements are
+ * smaller than v. That makes it an exact equi-depth histogram at the crack
+ * points, so selectivity is interpolated between the surrounding boundaries
+ * and the work of a query is the size of the (at most two) pieces that still
+ * have to be partitioned.
+ */
+
+namespace crackstore {
+
+struct QueryCostEstimate {
+    bool empty = false;             // The range provably holds no rows on this node
+    double expected_count = 0.0;    // Estimated result size
+    double expected_touched = 0.0;  // Estimated tuples partitioned by the query
+};
+
+namespace cost_model_detail {
+
+// Number of elements smaller than x, interpolated between known points
+inline double rank_below(const CrackSummary& s, long long x) {
+    long long lo_v = s.min_value, hi_v = static_cast<long long>(s.max_value) + 1;
+    double lo_p = 0.0, hi_p = s.total_rows;
+
+    if (x <= lo_v) return 0.0;
+    if (x >= hi_v) return s.total_rows;
+
+    auto it = std::lower_bound(
+        s.boundaries.begin(), s.boundaries.end(), x,
+        [](const std::pair<int, int>& b, long long v) { return b.first < v; });
+
+    if (it != s.boundaries.end()) {
+        if (it->first == x) return it->second;
+        if (it->first < hi_v) { hi_v = it->first; hi_p = it->second; }
+    }
+    if (it != s.boundaries.begin()) {
+        --it;
+        if (it->first > lo_v) { lo_v = it->first; lo_p = it->second; }
+    }
+
+    if (hi_v <= lo_v) return lo_p;
+    return lo_p + (hi_p - lo_p) * static_cast<double>(x - lo_v) / static_cast<double>(hi_v - lo_v);
+}
+
+// Size-biased mean piece size: the expected size of the piece a random
+// value falls into, derived from the power-of-two histogram
+inline double expected_piece_size(const CrackSummary& s) {
+    double weighted = 0.0, total = 0.0;
+    for (size_t k = 0; k < s.piece_size_histogram.size(); ++k) {
+        double size = 1.5 * static_cast<double>(1LL << k);
+        weighted += s.piece_size_histogram[k] * size * size;
+        total += s.piece_size_histogram[k] * size;
+    }
+    return total > 0.0 ? weighted / total : s.total_rows;
+}
+
+// Index of the sampled piece that find_piece() would return for x, and its
+// bounds [L, R). A value equal to a crack lands in the piece to its right.
+inline int locate_piece(const CrackSummary& s, int x, int& L, int& R) {
+    auto it = std::upper_bound(
+        s.boundaries.begin(), s.boundaries.end(), x,
+        [](int v, const std::pair<int, int>& b) { return v < b.first; });
+
+    R = (it == s.boundaries.end()) ? s.total_rows : it->second;
+    L = (it == s.boundaries.begin()) ? 0 : std::prev(it)->second;
+    return static_cast<int>(it - s.boundaries.begin());
+}
+
+} // namespace cost_model_detail
+
+
+/**
+ * Estimate result size and cracking work of [low, high) on one node.
+ */
+inline QueryCostEstimate estimate_query_cost(const CrackSummary& summary, int low, int high) {
+    using namespace cost_model_detail;
+
+    QueryCostEstimate estimate;
+    if (summary.total_rows == 0 || low >= high ||
+        summary.max_value < summary.min_value ||
+        high <= summary.min_value || low > summary.max_value) {
+        estimate.empty = true;
+        return estimate;
+    }
+
+    estimate.expected_count = std::max(0.0, rank_below(summary, high) - rank_below(summary, low));
+
+    // With every crack reported the pieces are exact; otherwise a sampled
+    // piece spans several real ones and the histogram gives a tighter bound
+    bool complete = static_cast<int>(summary.boundaries.size()) == summary.total_cracks;
+    double piece_cap = complete ? summary.total_rows : expected_piece_size(summary);
+
+    int L1, R1, L2, R2;
+    int p1 = locate_piece(summary, low, L1, R1);
+    int p2 = locate_piece(summary, high, L2, R2);
+
+    estimate.expected_touched = std::min<double>(R1 - L1, piece_cap);
+    if (p1 != p2 || !complete) {
+        estimate.expected_touched += std::min<double>(R2 - L2, piece_cap);
+    }
+
+    return estimate;
+}
+
+}
+
+#endif
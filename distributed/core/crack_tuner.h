@@ -0,0 +1,161 @@
+#ifndef CRACK_TUNER_H
+#define CRACK_TUNER_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * CrackTuner - Online choice of a column's stochastic cracking parameters
+ *
+ * Which parameters pay off depends on the workload: random ranges converge
+ * fastest with plain cracking, sequential or skewed ones need the random
+ * cracks of stochastic cracking (DDR, "Stochastic Database Cracking",
+ * Halim et al., VLDB 2012) and the test harness fixes them per binary. The
+ * tuner treats a few settings as the arms of a bandit instead, and plays
+ * one for an epoch of queries at a time.
+ *
+ * Costs fall as the index converges, so an arm's cost is only compared
+ * with the incumbent's in the epochs right before and after it: by their
+ * harmonic mean, which is exact when costs fall as 1/queries, as
+ * cracking's do on random ranges. The incumbent starts as arm 0, plain
+ * cracking, and a challenger replaces it when it costs less by a margin.
+ * Each challenger is tried once early on; one that loses waits twice as
+ * many epochs as before (more if it lost by more) before its next try, so
+ * the surer the tuner is of the incumbent the less it explores. A
+ * challenger's epoch ends early when its mean cost exceeds guard times the
+ * incumbent's. Costs are tuples touched per row (or query time); the tuner
+ * is deterministic.
+ */
+
+namespace crackstore {
+
+/**
+ * Stochastic cracking parameters: up to max_ncrack cracks on random values
+ * of a query bound's piece while it holds more than crack_at values, then
+ * the crack on the bound.
+ */
+struct CrackParams {
+    int max_ncrack = 0;           // 0 cracks on the query bounds only
+    int crack_at = 0;
+};
+
+struct CrackTunerConfig {
+    std::vector<CrackParams> arms = {
+        {0, 0}, {1, 1 << 16}, {1, 1 << 12}, {2, 1 << 12}, {4, 1 << 10}, {8, 1 << 7}
+    };
+    int epoch = 16;               // Queries per choice
+    double margin = 0.1;          // A challenger wins costing under (1 - margin) times the incumbent
+    int trial_gap = 4;            // Epochs before a challenger that lost is tried again, doubled per loss...
+    int max_gap = 64;             // ...up to this many
+    double guard = 1.5;           // End a challenger's epoch costing this many times the incumbent...
+    int guard_after = 4;          // ...after this many queries
+    bool by_time = false;         // Cost queries by time instead of tuples touched
+};
+
+
+class CrackTuner {
+public:
+    explicit CrackTuner(CrackTunerConfig config = CrackTunerConfig()) : config_(std::move(config)) {
+        if (config_.arms.empty()) config_.arms.push_back(CrackParams{});
+        config_.epoch = std::max(config_.epoch, 1);
+        config_.trial_gap = std::max(config_.trial_gap, 1);
+        cost_.assign(config_.arms.size(), -1.0);
+        gap_.assign(config_.arms.size(), config_.trial_gap);
+        next_trial_.assign(config_.arms.size(), 0);
+    }
+
+    /** The parameters for the next query. */
+    const CrackParams& params() const { return config_.arms[arm_]; }
+
+    const CrackTunerConfig& config() const { return config_; }
+    int arm() const { return arm_; }
+    int incumbent() const { return incumbent_; }
+    int epochs() const { return epochs_; }
+    int switches() const { return switches_; }
+    int guarded() const { return guarded_; }
+
+    /** Mean cost of an arm's last epoch, or -1 before it is played. */
+    double mean_cost(int arm) const { return cost_[arm]; }
+
+    /** The cost of a query run with params(). */
+    void observe(double cost) {
+        epoch_cost_ += cost;
+        ++epoch_queries_;
+        bool done = epoch_queries_ >= config_.epoch;
+        if (!done && arm_ != incumbent_ && epoch_queries_ >= config_.guard_after &&
+            epoch_cost_ / epoch_queries_ > config_.guard * std::max(before_, kMinCost)) {
+            done = true;
+            ++guarded_;
+        }
+        if (done) end_epoch();
+    }
+
+private:
+    static constexpr double kMinCost = 1e-9;  // Costs of a converged index are near 0
+
+    CrackTunerConfig config_;
+    std::vector<double> cost_;    // Mean cost of each arm's last epoch
+    std::vector<int> gap_;        // Epochs between a challenger's tries
+    std::vector<int> next_trial_; // Epoch of a challenger's next try
+    int arm_ = 0;
+    int incumbent_ = 0;
+    int challenger_ = -1;         // Played in the last epoch, waiting for the incumbent's next one
+    double before_ = 0.0;         // The incumbent's mean cost in its last epoch
+    double epoch_cost_ = 0.0;
+    int epoch_queries_ = 0;
+    int epochs_ = 0;
+    int switches_ = 0;
+    int guarded_ = 0;
+
+    void end_epoch() {
+        double cost = epoch_cost_ / epoch_queries_;
+        bool full = epoch_queries_ >= config_.epoch;
+        cost_[arm_] = cost;
+        epoch_cost_ = 0.0;
+        epoch_queries_ = 0;
+        ++epochs_;
+
+        if (arm_ == incumbent_) {
+            if (challenger_ >= 0) {
+                double after = std::max(cost, kMinCost), prior = std::max(before_, kMinCost);
+                judge(challenger_, cost_[challenger_] * (prior + after) / (2 * prior * after));
+                challenger_ = -1;
+            }
+            before_ = cost;
+        } else if (full) {
+            challenger_ = arm_;       // Judged after the incumbent's next epoch
+        } else {
+            judge(arm_, cost / std::max(before_, kMinCost));
+        }
+
+        int next = incumbent_;
+        if (challenger_ < 0 && cost_[incumbent_] >= 0) {
+            for (int a = 0; a < static_cast<int>(cost_.size()); ++a) {
+                if (a != incumbent_ && next_trial_[a] <= epochs_ && (next == incumbent_ || next_trial_[a] < next_trial_[next])) {
+                    next = a;
+                }
+            }
+        }
+        if (next != arm_) ++switches_;
+        arm_ = next;
+    }
+
+    /** A challenger's cost relative to the incumbent's at the same time. */
+    void judge(int arm, double ratio) {
+        if (ratio < 1.0 - config_.margin) {
+            gap_[incumbent_] = config_.trial_gap;
+            next_trial_[incumbent_] = epochs_ + config_.trial_gap;
+            incumbent_ = arm;
+            before_ = cost_[arm];
+            return;
+        }
+        gap_[arm] = static_cast<int>(std::min<double>(config_.max_gap, gap_[arm] * std::max(2.0, ratio)));
+        next_trial_[arm] = epochs_ + gap_[arm];
+    }
+};
+
+}
+
+#endif
@@ -9,6 +9,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <chrono>
+#include <memory>
+#include <random>
+
+#include "column_engine.h"
+#include "crack_tuner.h"
 
 /**
  * CrackingEngine - A self-contained adaptive indexing engine
@@ -25,32 +30,6 @@ namespace crackstore {
 
 
 
-struct CrackingStats {
-    // Cumulative statistics (lifetime of engine)
-    long long queries_executed = 0;
-    long long total_tuples_touched = 0;
-    long long total_cracks_created = 0;
-    double total_query_time_ms = 0.0;
-    
-    // Per-query statistics (reset after each query)
-    int last_tuples_touched = 0;
-    int last_cracks_created = 0;
-    double last_query_time_ms = 0.0;
-    int last_result_count = 0;
-    
-    void reset() {
-        queries_executed = 0;
-        total_tuples_touched = 0;
-        total_cracks_created = 0;
-        total_query_time_ms = 0.0;
-        last_tuples_touched = 0;
-        last_cracks_created = 0;
-        last_query_time_ms = 0.0;
-        last_result_count = 0;
-    }
-};
-
-
 struct CrackIndex {
     int pos;        // the cracker index position
     int holes;      // the number of holes in front (for updates)
@@ -64,8 +43,7 @@ using CrackMap = std::map<ValueType, CrackIndex>;
 using CrackMapIter = CrackMap::iterator;
 
 
-
-class CrackingEngine {
+class CrackingEngine : public ColumnEngine {
 public:
     
     /**
@@ -87,6 +65,12 @@ public:
         // Copy data
         std::memcpy(arr_, data, size * sizeof(int));
         
+        // Track the value domain for cost estimation
+        if (size > 0) {
+            min_value_ = *std::min_element(arr_, arr_ + size);
+            max_value_ = *std::max_element(arr_, arr_ + size);
+        }
+        
         // Initialize cracker index (empty)
         crack_index_.clear();
         
@@ -98,7 +82,7 @@ public:
         stats_.reset();
     }
     
-    ~CrackingEngine() {
+    ~CrackingEngine() override {
         delete[] arr_;
         arr_ = nullptr;
     }
@@ -112,10 +96,16 @@ public:
         arr_ = other.arr_;
         size_ = other.size_;
         capacity_ = other.capacity_;
+        min_value_ = other.min_value_;
+        max_value_ = other.max_value_;
         crack_index_ = std::move(other.crack_index_);
         pending_inserts_ = std::move(other.pending_inserts_);
         pending_deletes_ = std::move(other.pending_deletes_);
         stats_ = other.stats_;
+        last_begin_ = other.last_begin_;
+        params_ = other.params_;
+        tuner_ = std::move(other.tuner_);
+        rng_ = other.rng_;
         
         other.arr_ = nullptr;
         other.size_ = 0;
@@ -128,10 +118,16 @@ public:
             arr_ = other.arr_;
             size_ = other. size_;
             capacity_ = other.capacity_;
+            min_value_ = other.min_value_;
+            max_value_ = other.max_value_;
             crack_index_ = std::move(other.crack_index_);
             pending_inserts_ = std::move(other.pending_inserts_);
             pending_deletes_ = std::move(other.pending_deletes_);
             stats_ = other.stats_;
+            last_begin_ = other.last_begin_;
+            params_ = other.params_;
+            tuner_ = std::move(other.tuner_);
+            rng_ = other.rng_;
             
             other.arr_ = nullptr;
             other.size_ = 0;
@@ -149,13 +145,14 @@ public:
      * @param high  Upper bound (exclusive)
      * @return      Count of elements where low <= element < high
      */
-    int range_query(int low, int high) {
+    int range_query(int low, int high) override {
         auto start_time = std::chrono::high_resolution_clock::now();
         
       
         stats_.last_tuples_touched = 0;
         stats_.last_cracks_created = 0;
         int initial_cracks = static_cast<int>(crack_index_.size());
+        if (tuner_) params_ = tuner_->params();
         
         
         merge_pending_updates(low, high);
@@ -170,6 +167,13 @@ public:
         stats_.last_cracks_created = static_cast<int>(crack_index_. size()) - initial_cracks;
         stats_. last_query_time_ms = elapsed_ms;
         stats_.last_result_count = result;
+        stats_.max_ncrack = params_.max_ncrack;
+        stats_.crack_at = params_.crack_at;
+        
+        if (tuner_) {
+            tuner_->observe(tuner_->config().by_time ? elapsed_ms
+                            : static_cast<double>(stats_.last_tuples_touched) / std::max(size_, 1));
+        }
         
         stats_.queries_executed++;
         stats_.total_tuples_touched += stats_.last_tuples_touched;
@@ -179,13 +183,30 @@ public:
         return result;
     }
     
+    /**
+     * The qualifying values are contiguous in the cracked column: one run.
+     */
+    std::vector<ValueRun> range_view(int low, int high) override {
+        int count = range_query(low, high);
+        if (count == 0) return {};
+        return {ValueRun{arr_ + last_begin_, count}};
+    }
+    
     /**
      * Queue an insert operation.
      * The value will be merged into the data during the next relevant query.
      *
      * @param value  Value to insert
      */
-    void insert(int value) {
+    void insert(int value) override {
+        // Widen the domain now so summaries cover pending inserts
+        if (min_value_ > max_value_) {
+            min_value_ = max_value_ = value;
+        } else {
+            min_value_ = std::min(min_value_, value);
+            max_value_ = std::max(max_value_, value);
+        }
+        
         // If value is pending delete, cancel the delete instead
         auto it = pending_deletes_.find(value);
         if (it != pending_deletes_.end()) {
@@ -201,7 +222,7 @@ public:
      * 
      * @param value  Value to remove
      */
-    void remove(int value) {
+    void remove(int value) override {
         // If value is pending insert, cancel the insert instead
         auto it = pending_inserts_. find(value);
         if (it != pending_inserts_. end()) {
@@ -214,34 +235,90 @@ public:
 
     
 
-    CrackingStats get_stats() const {
+    CrackingStats get_stats() const override {
         return stats_;
     }
     
 
-    void reset_stats() {
+    void reset_stats() override {
         stats_.reset();
     }
     
 
-    int get_crack_count() const {
+    int get_crack_count() const override {
         return static_cast<int>(crack_index_. size());
     }
     
 
-    int get_size() const {
+    int get_size() const override {
         return size_;
     }
     
 
-    int get_pending_inserts() const {
+    int get_pending_inserts() const override {
         return static_cast<int>(pending_inserts_.size());
     }
     
 
-    int get_pending_deletes() const {
+    int get_pending_deletes() const override {
         return static_cast<int>(pending_deletes_.size());
     }
+    
+    /**
+     * Crack with fixed stochastic cracking parameters; the default crack on
+     * the query bounds only is {0, 0}. Turns tuning off.
+     */
+    void set_params(const CrackParams& params) {
+        params_ = params;
+        tuner_.reset();
+    }
+    
+    CrackParams get_params() const {
+        return params_;
+    }
+    
+    /**
+     * Let a CrackTuner pick the parameters of each query from its cost.
+     */
+    void enable_tuning(const CrackTunerConfig& config = CrackTunerConfig()) {
+        tuner_ = std::make_unique<CrackTuner>(config);
+    }
+    
+    /** The tuner, or nullptr when the parameters are fixed. */
+    const CrackTuner* get_tuner() const {
+        return tuner_.get();
+    }
+    
+    /**
+     * Summarize the cracker index for cost-based routing.
+     *
+     * @param max_boundaries  Upper bound on the crack points reported; when
+     *                        the index is larger an evenly spaced subset is kept
+     */
+    CrackSummary summarize(int max_boundaries) const override {
+        CrackSummary summary;
+        summary.total_rows = size_ + static_cast<int>(pending_inserts_.size());
+        summary.min_value = min_value_;
+        summary.max_value = max_value_;
+        summary.total_cracks = static_cast<int>(crack_index_.size());
+        
+        int stride = 1;
+        if (max_boundaries > 0 && summary.total_cracks > max_boundaries) {
+            stride = (summary.total_cracks + max_boundaries - 1) / max_boundaries;
+        }
+        
+        int prev = 0, nth = 0;
+        for (const auto& [value, index] : crack_index_) {
+            if (max_boundaries > 0 && nth++ % stride == 0) {
+                summary.boundaries.emplace_back(value, index.pos);
+            }
+            add_piece_to_histogram(summary.piece_size_histogram, index.prev_pos() - prev);
+            prev = index.pos;
+        }
+        add_piece_to_histogram(summary.piece_size_histogram, size_ - prev);
+        
+        return summary;
+    }
 
 private:
     int* arr_ = nullptr;          // The data array
@@ -255,6 +332,23 @@ private:
     
     CrackingStats stats_;         // Query statistics
     
+    int min_value_ = 0;           // Smallest value ever held (widened by inserts)
+    int max_value_ = -1;          // Largest value ever held (widened by inserts)
+    
+    int last_begin_ = 0;          // Where the last query's values start
+    
+    CrackParams params_;                  // Stochastic cracking of the next query
+    std::unique_ptr<CrackTuner> tuner_;   // Picks params_ per query, if tuning
+    std::minstd_rand rng_{160284};        // Random crack values
+    
+    static void add_piece_to_histogram(std::vector<int>& histogram, int piece_size) {
+        if (piece_size <= 0) return;
+        int k = 0;
+        while ((piece_size >> (k + 1)) > 0) ++k;
+        if (static_cast<int>(histogram.size()) <= k) histogram.resize(k + 1, 0);
+        histogram[k]++;
+    }
+    
     /**
      * Partition array segment [L, R) around value v.
      * After partitioning: all elements < v are before the returned position.
@@ -381,6 +475,13 @@ private:
         int L1, R1, L2, R2;
         int i1, i2;
         
+        if (params_.max_ncrack > 0) {
+            i1 = stochastic_crack(a);
+            i2 = stochastic_crack(b);
+            last_begin_ = i1;
+            return i2 - i1;
+        }
+        
         find_piece(a, L1, R1);
         find_piece(b, L2, R2);
         
@@ -400,9 +501,63 @@ private:
         add_crack(a, i1);
         add_crack(b, i2);
         
+        last_begin_ = i1;
         return i2 - i1;
     }
 
+    /**
+     * Crack on v after up to max_ncrack cracks on the median of three random
+     * values of v's piece, each keeping v's side, while the piece holds more
+     * than crack_at values (DDR).
+     *
+     * @return  Position where elements >= v begin
+     */
+    int stochastic_crack(int v) {
+        int L, R;
+        find_piece(v, L, R);
+        for (int n = params_.max_ncrack; n > 0 && R - L > params_.crack_at; --n) {
+            int x = arr_[L + rng_() % (R - L)];
+            int x2 = arr_[L + rng_() % (R - L)];
+            int x3 = arr_[L + rng_() % (R - L)];
+            if (x == x2 && x == x3) break;    // Mostly duplicates
+            if (x2 > x) std::swap(x, x2);
+            if (x > x3) std::swap(x, x3);
+            if (x2 > x) std::swap(x, x2);
+            
+            stats_.last_tuples_touched += R - L;
+            int m = partition(x, L, R);
+            add_crack(x, m);
+            if (v < x) R = m; else L = m;
+        }
+        stats_.last_tuples_touched += R - L;
+        return add_crack(v, partition(v, L, R));
+    }
+
+    void grow(int new_capacity) {
+        int* grown = new int[new_capacity];
+        std::memcpy(grown, arr_, size_ * sizeof(int));
+        delete[] arr_;
+        arr_ = grown;
+        capacity_ = new_capacity;
+    }
+    
+    /**
+     * Insert value into the piece that owns it. The hole opened at the end
+     * of the array moves left one piece at a time: the first element of each
+     * piece above value moves into the hole at that piece's end and the
+     * crack shifts right by one, so only one element per crack is touched.
+     */
+    void ripple_insert(int value) {
+        int hole = size_++;
+        for (auto it = crack_index_.rbegin(); it != crack_index_.rend() && it->first > value; ++it) {
+            int& pos = it->second.pos;
+            arr_[hole] = arr_[pos];
+            hole = pos++;
+            stats_.last_tuples_touched++;
+        }
+        arr_[hole] = value;
+    }
+    
     void merge_pending_updates(int low, int high) {
         // Process pending inserts in range
         auto ins_low = pending_inserts_.lower_bound(low);
@@ -412,11 +567,10 @@ private:
             int value = *it;
             it = pending_inserts_.erase(it);
             
-            
-            if (size_ < capacity_) {
-                arr_[size_++] = value;
+            if (size_ == capacity_) {
+                grow(std::max(capacity_ * 2, 1000));
             }
-            
+            ripple_insert(value);
         }
         
         
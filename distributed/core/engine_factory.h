@@ -0,0 +1,37 @@
+#ifndef ENGINE_FACTORY_H
+#define ENGINE_FACTORY_H
+
+#include <memory>
+#include <string>
+
+#include "column_engine.h"
+#include "cracking_engine.h"
+#include "adaptive_merging_engine.h"
+
+/**
+ * Engine selection (--engine): "crack" (CrackingEngine), "tuned"
+ * (CrackingEngine tuning its stochastic cracks per column, see
+ * crack_tuner.h) or "hybrid" (AdaptiveMergingEngine, crack-sort).
+ */
+
+namespace crackstore {
+
+inline bool is_column_engine(const std::string& kind) {
+    return kind == "crack" || kind == "tuned" || kind == "hybrid";
+}
+
+inline std::unique_ptr<ColumnEngine> make_column_engine(const std::string& kind, const int* data, int size) {
+    if (kind == "hybrid") {
+        return std::make_unique<AdaptiveMergingEngine>(data, size);
+    }
+    if (kind == "tuned") {
+        auto engine = std::make_unique<CrackingEngine>(data, size);
+        engine->enable_tuning();
+        return engine;
+    }
+    return std::make_unique<CrackingEngine>(data, size);
+}
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef PARTITIONER_H
+#define PARTITIONER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * Sample-based equi-depth range partitioning.
+ *
+ * Splitters are quantiles of a uniform random sample, so on skewed data
+ * each partition still receives about the same number of rows (unlike
+ * equal-width ranges). Partition i owns values in [splitters[i-1],
+ * splitters[i]); the first and last partitions are open-ended.
+ */
+
+namespace crackstore {
+
+struct PartitionPlan {
+    std::vector<int> splitters;            // parts - 1 ascending values
+    std::vector<long long> counts;         // Rows per partition under these splitters
+    double imbalance = 0.0;                // max(counts) / mean(counts) - 1
+    int samples_drawn = 0;                 // Size of the sample that produced the splitters
+    int attempts = 0;                      // Sampling rounds needed
+};
+
+struct PartitionOptions {
+    int sample_per_partition = 1000;       // Initial sample size is parts * this
+    double max_imbalance = 0.10;           // Re-sample above this
+    int max_attempts = 4;                  // Each retry doubles the sample
+    unsigned threads = 0;                  // 0 = hardware concurrency
+    uint64_t seed = 140384;
+};
+
+
+// Index of the partition that owns `value`
+inline int partition_of(const std::vector<int>& splitters, int value) {
+    return static_cast<int>(std::upper_bound(splitters.begin(), splitters.end(), value) - splitters.begin());
+}
+
+
+namespace partitioner_detail {
+
+inline unsigned resolve_threads(unsigned threads, size_t n) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, n / 65536 + 1)));
+}
+
+// Run fn(t, begin, end) over `threads` contiguous chunks of [0, n)
+template <typename Fn>
+void parallel_chunks(size_t n, unsigned threads, Fn fn) {
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t begin = n * t / threads, end = n * (t + 1) / threads;
+        workers.emplace_back(fn, t, begin, end);
+    }
+    for (auto& w : workers) w.join();
+}
+
+} // namespace partitioner_detail
+
+
+/**
+ * Draw `sample_size` rows uniformly at random, in parallel: each thread
+ * samples its chunk in proportion to the chunk's size.
+ */
+inline std::vector<int> draw_sample(const int* data, size_t n, size_t sample_size,
+                                    uint64_t seed, unsigned threads) {
+    using namespace partitioner_detail;
+    threads = resolve_threads(threads, n);
+    std::vector<std::vector<int>> parts(threads);
+
+    parallel_chunks(n, threads, [&](unsigned t, size_t begin, size_t end) {
+        if (begin == end) return;
+        size_t take = static_cast<size_t>(
+            static_cast<double>(sample_size) * (end - begin) / n + 0.5);
+        std::mt19937_64 rng(seed * 0x9E3779B97F4A7C15ULL + t);
+        std::uniform_int_distribution<size_t> pick(begin, end - 1);
+        parts[t].reserve(take);
+        for (size_t i = 0; i < take; ++i) {
+            parts[t].push_back(data[pick(rng)]);
+        }
+    });
+
+    std::vector<int> sample;
+    sample.reserve(sample_size);
+    for (const auto& p : parts) sample.insert(sample.end(), p.begin(), p.end());
+    return sample;
+}
+
+// Rows per partition, counted in parallel
+inline std::vector<long long> count_partitions(const int* data, size_t n,
+                                               const std::vector<int>& splitters, unsigned threads) {
+    using namespace partitioner_detail;
+    threads = resolve_threads(threads, n);
+    size_t parts = splitters.size() + 1;
+    std::vector<std::vector<long long>> local(threads, std::vector<long long>(parts, 0));
+
+    parallel_chunks(n, threads, [&](unsigned t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            local[t][partition_of(splitters, data[i])]++;
+        }
+    });
+
+    std::vector<long long> counts(parts, 0);
+    for (const auto& l : local) {
+        for (size_t p = 0; p < parts; ++p) counts[p] += l[p];
+    }
+    return counts;
+}
+
+/**
+ * Choose equi-depth splitters for `parts` partitions, re-sampling with a
+ * doubled sample while the measured imbalance exceeds the threshold. The
+ * best plan seen is returned; heavy duplicates can make perfect balance
+ * impossible since equal values always share a partition.
+ */
+inline PartitionPlan plan_partitions(const int* data, size_t n, int parts,
+                                     const PartitionOptions& options = PartitionOptions()) {
+    PartitionPlan best;
+    best.counts.assign(std::max(parts, 1), 0);
+    if (parts <= 1 || n == 0) {
+        best.counts[0] = static_cast<long long>(n);
+        return best;
+    }
+
+    size_t sample_size = static_cast<size_t>(parts) * options.sample_per_partition;
+    for (int attempt = 1; attempt <= options.max_attempts; ++attempt, sample_size *= 2) {
+        sample_size = std::min(sample_size, n);
+        std::vector<int> sample = draw_sample(data, n, sample_size, options.seed + attempt, options.threads);
+        std::sort(sample.begin(), sample.end());
+
+        PartitionPlan plan;
+        for (int k = 1; k < parts; ++k) {
+            plan.splitters.push_back(sample[sample.size() * k / parts]);
+        }
+        plan.counts = count_partitions(data, n, plan.splitters, options.threads);
+        long long largest = *std::max_element(plan.counts.begin(), plan.counts.end());
+        plan.imbalance = static_cast<double>(largest) * parts / n - 1.0;
+        plan.samples_drawn = static_cast<int>(sample.size());
+        plan.attempts = attempt;
+
+        if (best.attempts == 0 || plan.imbalance < best.imbalance) {
+            best = std::move(plan);
+        }
+        if (best.imbalance <= options.max_imbalance || sample_size == n) break;
+    }
+    return best;
+}
+
+// Rows of each partition, scattered in parallel (row order is kept)
+inline std::vector<std::vector<int>> split_by_partition(const int* data, size_t n,
+                                                        const PartitionPlan& plan, unsigned threads) {
+    using namespace partitioner_detail;
+    threads = resolve_threads(threads, n);
+    size_t parts = plan.splitters.size() + 1;
+    std::vector<std::vector<std::vector<int>>> local(threads, std::vector<std::vector<int>>(parts));
+
+    parallel_chunks(n, threads, [&](unsigned t, size_t begin, size_t end) {
+        for (size_t p = 0; p < parts; ++p) {
+            local[t][p].reserve((end - begin) / parts + 16);
+        }
+        for (size_t i = begin; i < end; ++i) {
+            local[t][partition_of(plan.splitters, data[i])].push_back(data[i]);
+        }
+    });
+
+    std::vector<std::vector<int>> out(parts);
+    for (size_t p = 0; p < parts; ++p) {
+        out[p].reserve(plan.counts[p]);
+        for (unsigned t = 0; t < threads; ++t) {
+            out[p].insert(out[p].end(), local[t][p].begin(), local[t][p].end());
+        }
+    }
+    return out;
+}
+
+}
+
+#endif
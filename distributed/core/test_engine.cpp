@@ -1,7 +1,12 @@
 #include "cracking_engine.h"
+#include "adaptive_merging_engine.h"
+#include "cost_model.h"
+#include "partitioner.h"
 #include <iostream>
 #include <random>
 #include <cassert>
+#include <algorithm>
+#include <cmath>
 
 using namespace crackstore;
 
@@ -147,6 +152,42 @@ void test_insert() {
     std::cout << "PASSED\n";
 }
 
+void test_insert_after_cracking() {
+    std::cout << "Test: Insert into cracked column... ";
+    
+    const int SIZE = 10000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<int> dist(0, 100000);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    // Small extra capacity so the inserts also grow the array
+    CrackingEngine engine(data.data(), SIZE, 10);
+    for (int i = 0; i < 50; ++i) {
+        int low = dist(rng);
+        engine.range_query(low, low + 2000);
+    }
+    
+    for (int i = 0; i < 3000; ++i) {
+        int value = dist(rng);
+        engine.insert(value);
+        data.push_back(value);
+    }
+    
+    // Inserts land in the piece that owns them, so cracks stay valid
+    for (int i = 0; i < 100; ++i) {
+        int low = dist(rng);
+        int high = low + dist(rng) % 20000;
+        assert(engine.range_query(low, high) ==
+               naive_range_count(data.data(), static_cast<int>(data.size()), low, high));
+    }
+    assert(engine.range_query(0, 100001) == static_cast<int>(data.size()));
+    
+    std::cout << "PASSED\n";
+}
+
 void test_remove() {
     std::cout << "Test: Remove operation... ";
     
@@ -225,6 +266,406 @@ void test_correctness_large() {
     std::cout << "PASSED (20 random queries verified)\n";
 }
 
+void test_summary() {
+    std::cout << "Test: Crack summary... ";
+    
+    const int SIZE = 10000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(777);
+    std::uniform_int_distribution<int> dist(100, 50000);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    CrackingEngine engine(data.data(), SIZE);
+    for (int i = 0; i < 50; ++i) {
+        int low = dist(rng);
+        engine.range_query(low, low + 1000);
+    }
+    
+    CrackSummary full = engine.summarize(1000000);
+    assert(full.total_rows == SIZE);
+    assert(full.min_value == *std::min_element(data.begin(), data.end()));
+    assert(full.max_value == *std::max_element(data.begin(), data.end()));
+    assert(full.total_cracks == engine.get_crack_count());
+    assert(static_cast<int>(full.boundaries.size()) == full.total_cracks);
+    
+    // Each boundary position is the number of elements below its value
+    for (const auto& [value, position] : full.boundaries) {
+        assert(position == naive_range_count(data.data(), SIZE, full.min_value, value));
+    }
+    
+    int pieces = 0;
+    for (int n : full.piece_size_histogram) pieces += n;
+    assert(pieces <= full.total_cracks + 1);
+    
+    CrackSummary sampled = engine.summarize(8);
+    assert(sampled.boundaries.size() <= 8);
+    assert(sampled.total_cracks == full.total_cracks);
+    assert(sampled.piece_size_histogram == full.piece_size_histogram);
+    
+    std::cout << "PASSED (cracks=" << full.total_cracks << ", pieces=" << pieces << ")\n";
+}
+
+void test_cost_estimate() {
+    std::cout << "Test: Cost estimate... ";
+    
+    const int SIZE = 100000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(4242);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    CrackingEngine engine(data.data(), SIZE);
+    
+    // Ranges outside the value domain are known to be empty
+    CrackSummary summary = engine.summarize(64);
+    assert(estimate_query_cost(summary, -100, 0).empty);
+    assert(estimate_query_cost(summary, 1000001, 2000000).empty);
+    assert(!estimate_query_cost(summary, 0, 1000).empty);
+    
+    // An uncracked column is one piece: the whole column is touched
+    QueryCostEstimate cold = estimate_query_cost(summary, 200000, 300000);
+    assert(cold.expected_touched == SIZE);
+    
+    for (int i = 0; i < 200; ++i) {
+        int low = dist(rng);
+        engine.range_query(low, low + 5000);
+    }
+    
+    // With every crack reported, touched matches the engine exactly and
+    // counts are interpolated within the two boundary pieces
+    summary = engine.summarize(1000000);
+    double max_count_error = 0.0;
+    for (int i = 0; i < 20; ++i) {
+        int low = dist(rng);
+        int high = low + 20000;
+        
+        QueryCostEstimate estimate = estimate_query_cost(summary, low, high);
+        int count = engine.range_query(low, high);
+        
+        assert(estimate.expected_touched == engine.get_stats().last_tuples_touched);
+        max_count_error = std::max(max_count_error, std::abs(estimate.expected_count - count));
+        summary = engine.summarize(1000000);
+    }
+    assert(max_count_error < 0.1 * 20000 * SIZE / 1000000.0);
+    
+    // A sampled summary still predicts selectivity of wide ranges closely
+    CrackSummary sampled = engine.summarize(16);
+    QueryCostEstimate wide = estimate_query_cost(sampled, 100000, 600000);
+    int actual = naive_range_count(data.data(), SIZE, 100000, 600000);
+    assert(std::abs(wide.expected_count - actual) < 0.05 * actual);
+    assert(wide.expected_touched > 0 && wide.expected_touched < SIZE);
+    
+    std::cout << "PASSED (max count error=" << max_count_error << ")\n";
+}
+
+void test_range_view() {
+    std::cout << "Test: Range view... ";
+    
+    const int SIZE = 10000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(31);
+    std::uniform_int_distribution<int> dist(0, 100000);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    CrackingEngine engine(data.data(), SIZE);
+    for (int i = 0; i < 50; ++i) {
+        int low = dist(rng);
+        int high = low + 5000;
+        std::vector<ValueRun> runs = engine.range_view(low, high);
+        assert(runs.size() <= 1);
+        
+        int size = 0;
+        for (const ValueRun& run : runs) {
+            for (int j = 0; j < run.size; ++j) {
+                assert(run.values[j] >= low && run.values[j] < high);
+            }
+            size += run.size;
+        }
+        assert(size == naive_range_count(data.data(), SIZE, low, high));
+        assert(size == engine.get_stats().last_result_count);
+    }
+    
+    std::cout << "PASSED\n";
+}
+
+void test_adaptive_merging() {
+    std::cout << "Test: Adaptive merging engine... ";
+    
+    const int SIZE = 100000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(2011);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    // Ten initial partitions, so extraction and compaction span several
+    AdaptiveMergingEngine engine(data.data(), SIZE, 10000);
+    assert(engine.get_size() == SIZE);
+    
+    for (int i = 0; i < 400; ++i) {
+        if (i % 10 == 9) {
+            for (int j = 0; j < 20; ++j) {
+                int value = dist(rng);
+                engine.insert(value);
+                data.push_back(value);
+                
+                int k = rng() % data.size();
+                engine.remove(data[k]);
+                data[k] = data.back();
+                data.pop_back();
+            }
+        }
+        
+        int low = dist(rng);
+        int high = low + dist(rng) % 50000;
+        int expected = naive_range_count(data.data(), static_cast<int>(data.size()), low, high);
+        
+        if (i % 2) {
+            assert(engine.range_query(low, high) == expected);
+        } else {
+            // Runs are sorted, in range and in value order
+            std::vector<ValueRun> runs = engine.range_view(low, high);
+            int size = 0, prev = low;
+            for (const ValueRun& run : runs) {
+                for (int j = 0; j < run.size; ++j) {
+                    assert(run.values[j] >= prev && run.values[j] < high);
+                    prev = run.values[j];
+                }
+                size += run.size;
+            }
+            assert(size == expected);
+        }
+    }
+    
+    // Repeated ranges are answered from final partitions: nothing cracked
+    engine.range_query(0, 1000001);
+    assert(engine.range_query(0, 1000001) == static_cast<int>(data.size()));
+    assert(engine.get_stats().last_tuples_touched == 0);
+    assert(engine.get_size() == static_cast<int>(data.size()));
+    assert(engine.get_pending_inserts() == 0 && engine.get_pending_deletes() == 0);
+
+    // Updates are merged into the queried slice of a final partition only;
+    // values may be negative, and deletes of values not held are dropped
+    int slice = naive_range_count(data.data(), static_cast<int>(data.size()), 499990, 500010);
+    engine.insert(500000);
+    engine.insert(500000);
+    engine.insert(-3);
+    engine.remove(-7);
+    data.push_back(500000);
+    data.push_back(500000);
+    data.push_back(-3);
+    assert(engine.range_query(499990, 500010) == slice + 2);
+    assert(engine.get_stats().last_tuples_touched == slice + 2);
+    assert(engine.range_query(-10, 0) == 1);
+    assert(engine.range_query(-10, 1000001) == static_cast<int>(data.size()));
+    assert(engine.get_pending_deletes() == 0);
+
+    // Empty columns and ranges
+    AdaptiveMergingEngine empty(data.data(), 0);
+    empty.insert(5);
+    assert(empty.range_query(0, 10) == 1);
+    assert(empty.range_query(10, 0) == 0);
+    
+    std::cout << "PASSED (final partitions=" << engine.get_final_partition_count() << ")\n";
+}
+
+void test_adaptive_merging_summary() {
+    std::cout << "Test: Adaptive merging summary... ";
+    
+    const int SIZE = 100000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(4711);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    AdaptiveMergingEngine engine(data.data(), SIZE, 30000);
+    for (int i = 0; i < 100; ++i) {
+        int low = dist(rng);
+        engine.range_query(low, low + 5000);
+        
+        int value = dist(rng);
+        engine.insert(value);
+        data.push_back(value);
+    }
+    engine.range_query(0, 1000001);   // merges the remaining inserts
+    
+    // Every boundary position is exact, however the rows got there
+    CrackSummary full = engine.summarize(1000000);
+    assert(full.total_rows == static_cast<int>(data.size()));
+    assert(static_cast<int>(full.boundaries.size()) == full.total_cracks);
+    for (const auto& [value, position] : full.boundaries) {
+        assert(position == naive_range_count(data.data(), static_cast<int>(data.size()), full.min_value, value));
+    }
+    
+    // Sorted final partitions cost a search, not a piece
+    QueryCostEstimate estimate = estimate_query_cost(full, 200000, 300000);
+    int count = naive_range_count(data.data(), static_cast<int>(data.size()), 200000, 300000);
+    assert(std::abs(estimate.expected_count - count) <= 1);
+    assert(estimate.expected_touched <= 2);
+    
+    CrackSummary sampled = engine.summarize(16);
+    assert(sampled.boundaries.size() <= 16);
+    assert(sampled.total_cracks > 16);
+    
+    std::cout << "PASSED (boundaries=" << full.total_cracks << ")\n";
+}
+
+void test_crack_tuner() {
+    std::cout << "Test: Crack tuner... ";
+    
+    // Arm 3 costs a third of the others: it ends up played most
+    CrackTuner tuner;
+    int played[6] = {0};
+    for (int q = 0; q < 6400; ++q) {
+        int arm = tuner.arm();
+        if (q >= 3200) played[arm]++;
+        tuner.observe(arm == 3 ? 1.0 : 3.0);
+    }
+    assert(played[3] > 3200 * 7 / 10);
+    assert(tuner.mean_cost(3) == 1.0);
+    
+    // A challenger costing more than guard times the incumbent is cut short
+    CrackTuner guarded;
+    for (int q = 0; q < 16; ++q) guarded.observe(1.0);
+    assert(guarded.epochs() == 1 && guarded.arm() == 1);
+    for (int q = 0; q < 4; ++q) guarded.observe(10.0);
+    assert(guarded.epochs() == 2 && guarded.guarded() == 1 && guarded.arm() == 2);
+    
+    // Against a converged incumbent costing 0, a loser waits max_gap epochs
+    CrackTuner converged;
+    int arm1_tries = 0;
+    while (converged.epochs() < 60) {
+        int arm = converged.arm(), epochs = converged.epochs();
+        converged.observe(arm == 0 ? 0.0 : 1.0);
+        if (arm == 1 && converged.epochs() > epochs) arm1_tries++;
+    }
+    assert(arm1_tries == 1);
+    
+    std::cout << "PASSED (best arm played " << played[3] << "/3200)\n";
+}
+
+void test_stochastic_cracking() {
+    std::cout << "Test: Stochastic cracking... ";
+    
+    const int SIZE = 100000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(2012);
+    std::uniform_int_distribution<int> dist(0, SIZE);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    // Fixed parameters, then tuned ones, against plain cracking on a
+    // sequential workload, where plain cracking re-reads the column's tail
+    CrackingEngine plain(data.data(), SIZE);
+    CrackingEngine fixed(data.data(), SIZE);
+    CrackingEngine tuned(data.data(), SIZE);
+    fixed.set_params(CrackParams{4, 64});
+    tuned.enable_tuning();
+    
+    for (int i = 0; i < 1000; ++i) {
+        int low = i * (SIZE / 1000), high = low + SIZE / 500;
+        int expected = naive_range_count(data.data(), SIZE, low, high);
+        assert(plain.range_query(low, high) == expected);
+        assert(fixed.range_query(low, high) == expected);
+        assert(tuned.range_query(low, high) == expected);
+        
+        assert(fixed.get_stats().max_ncrack == 4 && fixed.get_stats().crack_at == 64);
+        CrackParams chosen = tuned.get_params();
+        assert(tuned.get_stats().max_ncrack == chosen.max_ncrack);
+        assert(tuned.get_stats().crack_at == chosen.crack_at);
+    }
+    assert(fixed.get_tuner() == nullptr);
+    assert(tuned.get_tuner()->epochs() > 0);
+    
+    long long plain_touched = plain.get_stats().total_tuples_touched;
+    long long tuned_touched = tuned.get_stats().total_tuples_touched;
+    assert(fixed.get_stats().total_tuples_touched < plain_touched);
+    assert(tuned_touched < plain_touched);
+    
+    // Views stay one run of the qualifying values
+    std::vector<ValueRun> runs = tuned.range_view(250, 40000);
+    assert(runs.size() == 1 && runs[0].size == naive_range_count(data.data(), SIZE, 250, 40000));
+    for (int j = 0; j < runs[0].size; ++j) {
+        assert(runs[0].values[j] >= 250 && runs[0].values[j] < 40000);
+    }
+    
+    std::cout << "PASSED (touched " << tuned_touched << " tuned vs " << plain_touched << " plain, "
+              << tuned.get_tuner()->switches() << " switches)\n";
+}
+
+void test_tuned_random_workload() {
+    std::cout << "Test: Tuned cracking on random ranges... ";
+    
+    const int SIZE = 1000000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(2009);
+    std::uniform_int_distribution<int> dist(0, SIZE);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = dist(rng);
+    }
+    
+    // Plain cracking is the best setting here: the tuner has to find out
+    // early and keep it, exploring the others rarely
+    CrackingEngine plain(data.data(), SIZE);
+    CrackingEngine tuned(data.data(), SIZE);
+    tuned.enable_tuning();
+    for (int i = 0; i < 1000; ++i) {
+        int low = dist(rng), high = low + SIZE / 100;
+        assert(tuned.range_query(low, high) == plain.range_query(low, high));
+    }
+    
+    long long plain_touched = plain.get_stats().total_tuples_touched;
+    long long tuned_touched = tuned.get_stats().total_tuples_touched;
+    assert(tuned_touched < plain_touched * 11 / 10);
+    
+    std::cout << "PASSED (touched " << tuned_touched << " tuned vs " << plain_touched << " plain)\n";
+}
+
+void test_partitioner() {
+    std::cout << "Test: Equi-depth partitioning... ";
+    
+    // Heavily skewed data: equal-width ranges would put most rows in one node
+    const int SIZE = 400000;
+    std::vector<int> data(SIZE);
+    std::mt19937 rng(777);
+    std::exponential_distribution<double> dist(1.0 / 5000.0);
+    for (int i = 0; i < SIZE; ++i) {
+        data[i] = static_cast<int>(dist(rng));
+    }
+    
+    PartitionPlan plan = plan_partitions(data.data(), SIZE, 8);
+    assert(plan.splitters.size() == 7);
+    assert(std::is_sorted(plan.splitters.begin(), plan.splitters.end()));
+    assert(plan.imbalance <= PartitionOptions().max_imbalance);
+    
+    std::vector<std::vector<int>> parts = split_by_partition(data.data(), SIZE, plan, 4);
+    long long total = 0;
+    for (size_t p = 0; p < parts.size(); ++p) {
+        assert(static_cast<long long>(parts[p].size()) == plan.counts[p]);
+        for (int v : parts[p]) {
+            assert(partition_of(plan.splitters, v) == static_cast<int>(p));
+        }
+        total += parts[p].size();
+    }
+    assert(total == SIZE);
+    
+    // A single partition takes everything without sampling
+    PartitionPlan single = plan_partitions(data.data(), SIZE, 1);
+    assert(single.splitters.empty() && single.counts[0] == SIZE);
+    
+    std::cout << "PASSED" << std::endl;
+}
+
 int main() {
     std::cout << "\n=== CrackingEngine Test Suite ===\n\n";
     
@@ -235,9 +676,19 @@ int main() {
     test_adaptive_behavior();
     test_different_ranges();
     test_insert();
+    test_insert_after_cracking();
     test_remove();
     test_statistics();
     test_correctness_large();
+    test_summary();
+    test_cost_estimate();
+    test_range_view();
+    test_adaptive_merging();
+    test_adaptive_merging_summary();
+    test_crack_tuner();
+    test_stochastic_cracking();
+    test_tuned_random_workload();
+    test_partitioner();
     
     std::cout << "\n=== All Tests Passed ===\n\n";
     return 0;
@@ -1,21 +1,17 @@
 #include <iostream>
 #include <memory>
 #include <string>
-#include <map>
-#include <mutex>
 #include <thread>
 #include <chrono>
 #include <atomic>
 #include <csignal>
 
 #include <grpcpp/grpcpp.h>
-#include "crackstore.grpc.pb.h"
-#include "cracking_engine.h"
+#include "storage_service.h"
+#include "channel_pool.h"
 
 using grpc::Server;
 using grpc::ServerBuilder;
-using grpc::ServerContext;
-using grpc::Status;
 using grpc::Channel;
 using grpc::ClientContext;
 
@@ -31,140 +27,6 @@ void signal_handler(int signal) {
 }
 
 
-class StorageServiceImpl final : public StorageService::Service {
-public:
-    StorageServiceImpl(const std::string& node_id) : node_id_(node_id) {
-        std::cout << "[StorageNode:" << node_id_ << "] Service initialized\n";
-    }
-
-    
-    Status LoadColumn(ServerContext* context,
-                      const LoadColumnRequest* request,
-                      LoadColumnResponse* response) override {
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        const std::string& column_name = request->column_name();
-        int data_size = request->data_size();
-        
-        std::cout << "[StorageNode:" << node_id_ << "] LoadColumn: "
-                  << column_name << " (" << data_size << " rows)\n";
-        
-        if (data_size == 0) {
-            response->set_success(false);
-            response->set_rows_loaded(0);
-            response->set_node_id(node_id_);
-            return Status::OK;
-        }
-        
-        // Copy data from protobuf to vector
-        std::vector<int> data(data_size);
-        for (int i = 0; i < data_size; ++i) {
-            data[i] = request->data(i);
-        }
-        
-        // Create or replace cracking engine for this column
-        columns_[column_name] = std::make_unique<CrackingEngine>(
-            data.data(), data_size
-        );
-        
-        response->set_success(true);
-        response->set_rows_loaded(data_size);
-        response->set_node_id(node_id_);
-        
-        std::cout << "[StorageNode:" << node_id_ << "] Column " << column_name 
-                  << " loaded successfully\n";
-        
-        return Status::OK;
-    }
-
- 
-    // RangeQuery - Execute cracking range query
-    Status RangeQuery(ServerContext* context,
-                      const RangeQueryRequest* request,
-                      RangeQueryResponse* response) override {
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        const std::string& column_name = request->column_name();
-        int low = request->low();
-        int high = request->high();
-        
-       
-        auto it = columns_.find(column_name);
-        if (it == columns_.end()) {
-            response->set_success(false);
-            response->set_error_message("Column not found: " + column_name);
-            response->set_node_id(node_id_);
-            response->set_count(0);
-            return Status::OK;
-        }
-        
-        CrackingEngine* engine = it->second.get();
-        
-        
-        int count = engine->range_query(low, high);
-        CrackingStats stats = engine->get_stats();
-        
-       
-        response->set_success(true);
-        response->set_count(count);
-        response->set_node_id(node_id_);
-        
-        auto* query_stats = response->mutable_stats();
-        query_stats->set_tuples_touched(stats.last_tuples_touched);
-        query_stats->set_cracks_used(engine->get_crack_count());
-        query_stats->set_query_time_ms(stats.last_query_time_ms);
-        
-        std::cout << "[StorageNode:" << node_id_ << "] RangeQuery [" << low << ", " << high << "): "
-                  << "count=" << count 
-                  << ", touched=" << stats.last_tuples_touched
-                  << ", cracks=" << engine->get_crack_count() << "\n";
-        
-        return Status::OK;
-    }
-
-    Status GetNodeInfo(ServerContext* context,
-                       const NodeInfoRequest* request,
-                       NodeInfoResponse* response) override {
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        response->set_node_id(node_id_);
-        response->set_is_healthy(true);
-        
-        int total_rows = 0;
-        int total_cracks = 0;
-        
-        for (const auto& [name, engine] : columns_) {
-            response->add_columns(name);
-            total_rows += engine->get_size();
-            total_cracks += engine->get_crack_count();
-        }
-        
-        response->set_total_rows(total_rows);
-        response->set_total_cracks(total_cracks);
-        
-        return Status::OK;
-    }
-
-
-    Status HealthCheck(ServerContext* context,
-                       const Empty* request,
-                       StatusResponse* response) override {
-        
-        response->set_success(true);
-        response->set_message("OK");
-        return Status::OK;
-    }
-
-private:
-    std::string node_id_;
-    std::map<std::string, std::unique_ptr<CrackingEngine>> columns_;
-    std::mutex mutex_;
-};
-
-
 class CoordinatorClient {
 public:
     CoordinatorClient(std::shared_ptr<Channel> channel)
@@ -192,10 +54,7 @@ public:
         }
     }
 
-    bool SendHeartbeat(const std::string& node_id) {
-        HeartbeatRequest request;
-        request.set_node_id(node_id);
-
+    bool SendHeartbeat(const HeartbeatRequest& request) {
         HeartbeatResponse response;
         ClientContext context;
         context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(2));
@@ -210,6 +69,7 @@ private:
 
 
 void heartbeat_loop(CoordinatorClient* client, 
+                    StorageServiceImpl* service,
                     const std::string& node_id,
                     int interval_seconds) {
     while (!g_shutdown_requested) {
@@ -217,7 +77,11 @@ void heartbeat_loop(CoordinatorClient* client,
         
         if (g_shutdown_requested) break;
         
-        if (!client->SendHeartbeat(node_id)) {
+        HeartbeatRequest request;
+        request.set_node_id(node_id);
+        service->FillColumnSummaries(&request, kSummaryBoundaries);
+        
+        if (!client->SendHeartbeat(request)) {
             std::cerr << "[StorageNode] Heartbeat failed\n";
         }
     }
@@ -234,6 +98,9 @@ void print_usage(const char* program) {
               << "  --node-id ID          Node identifier (default: auto-assigned)\n"
               << "  --heartbeat SEC       Heartbeat interval in seconds (default: 5)\n"
               << "  --standalone          Run without coordinator\n"
+              << "  --trace-file PATH     Write Chrome trace-event JSON spans to PATH on shutdown\n"
+              << "  --engine KIND         Column engine: crack, tuned (self-tuning stochastic\n"
+              << "                        cracking) or hybrid (crack-sort) (default: crack)\n"
               << "  --help                Show this help\n";
 }
 
@@ -244,6 +111,8 @@ int main(int argc, char** argv) {
     std::string node_id = "";
     int heartbeat_interval = 5;
     bool standalone = false;
+    std::string trace_file;
+    std::string engine = "crack";
 
     // Parse arguments
     for (int i = 1; i < argc; ++i) {
@@ -259,6 +128,15 @@ int main(int argc, char** argv) {
             heartbeat_interval = std::stoi(argv[++i]);
         } else if (arg == "--standalone") {
             standalone = true;
+        } else if (arg == "--trace-file" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg == "--engine" && i + 1 < argc) {
+            engine = argv[++i];
+            if (!is_column_engine(engine)) {
+                std::cerr << "Unknown engine: " << engine << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
         } else if (arg == "--help") {
             print_usage(argv[0]);
             return 0;
@@ -284,26 +162,18 @@ int main(int argc, char** argv) {
               << "  Coordinator: " << (standalone ? "standalone mode" : coordinator_address) << "\n";
 
     // Create coordinator client and register (unless standalone)
+    ChannelPool channel_pool;
     std::unique_ptr<CoordinatorClient> coordinator_client;
     std::thread heartbeat_thread;
 
     if (!standalone) {
-        auto channel = grpc::CreateChannel(coordinator_address, grpc::InsecureChannelCredentials());
-        coordinator_client = std::make_unique<CoordinatorClient>(channel);
+        coordinator_client = std::make_unique<CoordinatorClient>(channel_pool.Get(coordinator_address));
 
         std::string assigned_id;
         if (coordinator_client->RegisterNode("localhost", port, assigned_id)) {
             if (!assigned_id.empty()) {
                 node_id = assigned_id;
             }
-            
-            // Start heartbeat thread
-            heartbeat_thread = std::thread(
-                heartbeat_loop, 
-                coordinator_client.get(), 
-                node_id, 
-                heartbeat_interval
-            );
         } else {
             std::cerr << "[StorageNode] Warning: Could not register with coordinator, running standalone\n";
             standalone = true;
@@ -312,9 +182,25 @@ int main(int argc, char** argv) {
 
     // Create and start gRPC server
     std::string server_address = "0.0.0.0:" + std::to_string(port);
-    StorageServiceImpl service(node_id);
+    if (!trace_file.empty()) {
+        Tracer::instance().enable(trace_file, "storage " + node_id);
+    }
+
+    StorageServiceImpl service(node_id, engine);
+
+    // Heartbeats carry crack summaries, so they start once the service exists
+    if (!standalone) {
+        heartbeat_thread = std::thread(
+            heartbeat_loop, 
+            coordinator_client.get(), 
+            &service,
+            node_id, 
+            heartbeat_interval
+        );
+    }
 
     ServerBuilder builder;
+    ConfigureServerBuilder(builder, channel_pool.options());
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     builder.RegisterService(&service);
 
@@ -343,6 +229,14 @@ int main(int argc, char** argv) {
         heartbeat_thread.join();
     }
 
+    if (!trace_file.empty()) {
+        if (Tracer::instance().flush()) {
+            std::cout << "[StorageNode] Trace written to " << trace_file << "\n";
+        } else {
+            std::cerr << "[StorageNode] Failed to write trace to " << trace_file << "\n";
+        }
+    }
+
     std::cout << "[StorageNode] Stopped\n";
     return 0;
 }
\ No newline at end of file
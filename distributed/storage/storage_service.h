@@ -0,0 +1,317 @@
+#ifndef STORAGE_SERVICE_H
+#define STORAGE_SERVICE_H
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+#include <grpcpp/grpcpp.h>
+#include "crackstore.grpc.pb.h"
+#include "engine_factory.h"
+#include "tracing.h"
+
+/**
+ * Storage node service: one column engine per column, CrackingEngine or
+ * AdaptiveMergingEngine (see engine_factory.h). Hosted by the storage_node
+ * binary and by in-process clusters.
+ */
+
+namespace crackstore {
+
+using grpc::ServerContext;
+using grpc::ServerReader;
+using grpc::Status;
+
+// Crack points per column shipped with each heartbeat
+constexpr int kSummaryBoundaries = 256;
+
+
+class StorageServiceImpl final : public StorageService::Service {
+public:
+    StorageServiceImpl(const std::string& node_id, const std::string& engine = "crack")
+        : node_id_(node_id), engine_(engine) {
+        std::cout << "[StorageNode:" << node_id_ << "] Service initialized (" << engine_ << " engine)\n";
+    }
+
+    
+    Status LoadColumn(ServerContext* context,
+                      const LoadColumnRequest* request,
+                      LoadColumnResponse* response) override {
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        const std::string& column_name = request->column_name();
+        int data_size = request->data_size();
+        
+        std::cout << "[StorageNode:" << node_id_ << "] LoadColumn: "
+                  << column_name << " (" << data_size << " rows)\n";
+        
+        if (data_size == 0) {
+            response->set_success(false);
+            response->set_rows_loaded(0);
+            response->set_node_id(node_id_);
+            return Status::OK;
+        }
+        
+        // Copy data from protobuf to vector
+        std::vector<int> data(data_size);
+        for (int i = 0; i < data_size; ++i) {
+            data[i] = request->data(i);
+        }
+        
+        // Create or replace the engine for this column
+        columns_[column_name] = make_column_engine(engine_, data.data(), data_size);
+        
+        response->set_success(true);
+        response->set_rows_loaded(data_size);
+        response->set_node_id(node_id_);
+        
+        std::cout << "[StorageNode:" << node_id_ << "] Column " << column_name 
+                  << " loaded successfully\n";
+        
+        return Status::OK;
+    }
+
+ 
+    // LoadColumnStream - Same as LoadColumn, with the rows arriving in chunks.
+    // Chunks are collected without the lock so queries on other columns
+    // keep running during the transfer
+    Status LoadColumnStream(ServerContext* context,
+                            ServerReader<LoadColumnChunk>* reader,
+                            LoadColumnResponse* response) override {
+        
+        Span span("storage.LoadColumnStream", extract_trace_context(*context));
+        
+        std::string column_name;
+        std::vector<int> data;
+        LoadColumnChunk chunk;
+        int chunks = 0;
+        while (reader->Read(&chunk)) {
+            if (chunks++ == 0) {
+                column_name = chunk.column_name();
+                if (chunk.expected_rows() > 0) data.reserve(chunk.expected_rows());
+            }
+            data.insert(data.end(), chunk.data().begin(), chunk.data().end());
+        }
+        
+        response->set_node_id(node_id_);
+        if (chunks == 0 || column_name.empty()) {
+            response->set_success(false);
+            response->set_rows_loaded(0);
+            return Status::OK;
+        }
+        span.set_arg("column", column_name);
+        span.set_arg("rows", static_cast<long long>(data.size()));
+        
+        // A range partition can legitimately be empty, so unlike LoadColumn
+        // an empty stream still creates the column
+        auto engine = make_column_engine(engine_, data.data(), static_cast<int>(data.size()));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            columns_[column_name] = std::move(engine);
+        }
+        
+        std::cout << "[StorageNode:" << node_id_ << "] LoadColumnStream: " << column_name
+                  << " (" << data.size() << " rows in " << chunks << " chunks)\n";
+        
+        response->set_success(true);
+        response->set_rows_loaded(static_cast<int>(data.size()));
+        return Status::OK;
+    }
+
+    // RangeQuery - Execute cracking range query
+    Status RangeQuery(ServerContext* context,
+                      const RangeQueryRequest* request,
+                      RangeQueryResponse* response) override {
+        
+        Span span("storage.RangeQuery", extract_trace_context(*context));
+        
+        Span lock_wait("storage.lock_wait", span.context());
+        std::lock_guard<std::mutex> lock(mutex_);
+        lock_wait.end();
+        
+        ExecuteRangeQuery(*request, response, span.context());
+        return Status::OK;
+    }
+
+    // BatchRangeQuery - Execute coalesced queries under a single lock acquisition
+    Status BatchRangeQuery(ServerContext* context,
+                           const BatchRangeQueryRequest* request,
+                           BatchRangeQueryResponse* response) override {
+        
+        Span span("storage.BatchRangeQuery", extract_trace_context(*context));
+        span.set_arg("ranges", request->queries_size());
+        
+        Span lock_wait("storage.lock_wait", span.context());
+        std::lock_guard<std::mutex> lock(mutex_);
+        lock_wait.end();
+        
+        for (const auto& query : request->queries()) {
+            ExecuteRangeQuery(query, response->add_results(), span.context());
+        }
+        response->set_node_id(node_id_);
+        
+        return Status::OK;
+    }
+
+    Status Update(ServerContext* context,
+                  const UpdateRequest* request,
+                  UpdateResponse* response) override {
+        
+        Span span("storage.Update", extract_trace_context(*context));
+        span.set_arg("inserts", request->inserts_size());
+        span.set_arg("deletes", request->deletes_size());
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto it = columns_.find(request->column_name());
+        if (it == columns_.end()) {
+            response->set_success(false);
+            response->set_error_message("Column not found: " + request->column_name());
+            return Status::OK;
+        }
+        
+        ColumnEngine* engine = it->second.get();
+        for (int value : request->inserts()) {
+            engine->insert(value);
+        }
+        for (int value : request->deletes()) {
+            engine->remove(value);
+        }
+        
+        response->set_success(true);
+        response->set_inserted(request->inserts_size());
+        response->set_deleted(request->deletes_size());
+        return Status::OK;
+    }
+
+    Status GetNodeInfo(ServerContext* context,
+                       const NodeInfoRequest* request,
+                       NodeInfoResponse* response) override {
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        response->set_node_id(node_id_);
+        response->set_is_healthy(true);
+        
+        int total_rows = 0;
+        int total_cracks = 0;
+        
+        for (const auto& [name, engine] : columns_) {
+            response->add_columns(name);
+            total_rows += engine->get_size();
+            total_cracks += engine->get_crack_count();
+        }
+        
+        response->set_total_rows(total_rows);
+        response->set_total_cracks(total_cracks);
+        
+        return Status::OK;
+    }
+
+
+    Status HealthCheck(ServerContext* context,
+                       const Empty* request,
+                       StatusResponse* response) override {
+        
+        response->set_success(true);
+        response->set_message("OK");
+        return Status::OK;
+    }
+    
+    // Per-query log lines; off for benchmarks
+    void set_query_logging(bool enabled) { log_queries_ = enabled; }
+    
+    // Attach a crack summary of every column for the coordinator's cost model
+    void FillColumnSummaries(HeartbeatRequest* request, int max_boundaries) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        for (const auto& [name, engine] : columns_) {
+            CrackSummary summary = engine->summarize(max_boundaries);
+            
+            auto* column = request->add_columns();
+            column->set_column_name(name);
+            column->set_total_rows(summary.total_rows);
+            column->set_min_value(summary.min_value);
+            column->set_max_value(summary.max_value);
+            column->set_total_cracks(summary.total_cracks);
+            for (const auto& [value, position] : summary.boundaries) {
+                auto* boundary = column->add_boundaries();
+                boundary->set_value(value);
+                boundary->set_position(position);
+            }
+            for (int pieces : summary.piece_size_histogram) {
+                column->add_piece_size_histogram(pieces);
+            }
+        }
+    }
+
+private:
+    std::string node_id_;
+    std::string engine_;          // engine_factory.h kind for new columns
+    std::map<std::string, std::unique_ptr<ColumnEngine>> columns_;
+    std::mutex mutex_;
+    std::atomic<bool> log_queries_{true};
+
+    // Caller must hold mutex_
+    void ExecuteRangeQuery(const RangeQueryRequest& request, RangeQueryResponse* response,
+                           const TraceContext& trace) {
+        const std::string& column_name = request.column_name();
+        int low = request.low();
+        int high = request.high();
+        
+        Span span("storage.crack", trace);
+        span.set_arg("column", column_name);
+        span.set_arg("low", low);
+        span.set_arg("high", high);
+        
+       
+        auto it = columns_.find(column_name);
+        if (it == columns_.end()) {
+            response->set_success(false);
+            response->set_error_message("Column not found: " + column_name);
+            response->set_node_id(node_id_);
+            response->set_count(0);
+            return;
+        }
+        
+        ColumnEngine* engine = it->second.get();
+        
+        
+        int count = engine->range_query(low, high);
+        CrackingStats stats = engine->get_stats();
+        
+       
+        response->set_success(true);
+        response->set_count(count);
+        response->set_node_id(node_id_);
+        
+        auto* query_stats = response->mutable_stats();
+        query_stats->set_tuples_touched(stats.last_tuples_touched);
+        query_stats->set_cracks_used(engine->get_crack_count());
+        query_stats->set_query_time_ms(stats.last_query_time_ms);
+        query_stats->set_max_ncrack(stats.max_ncrack);
+        query_stats->set_crack_at(stats.crack_at);
+        
+        span.set_arg("count", count);
+        span.set_arg("tuples_touched", stats.last_tuples_touched);
+        if (stats.max_ncrack > 0) {
+            span.set_arg("max_ncrack", stats.max_ncrack);
+            span.set_arg("crack_at", stats.crack_at);
+        }
+        
+        if (log_queries_) {
+            std::cout << "[StorageNode:" << node_id_ << "] RangeQuery [" << low << ", " << high << "): "
+                      << "count=" << count 
+                      << ", touched=" << stats.last_tuples_touched
+                      << ", cracks=" << engine->get_crack_count() << "\n";
+        }
+    }
+};
+
+}
+
+#endif
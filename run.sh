@@ -14,39 +14,27 @@ function run {
 	bin/$PROG data/$DATA $Q $SEL $WORK $UPDT $Qret $T # run the program
 
 	FN="${PROG}_${DATA}_${SEL}_${WORK}_${UPDT}_${Qret}"
-	mv res/result_size.gz res/${FN}.result_size.gz
-	mv res/examined.gz res/${FN}.examined.gz
-	mv res/n_cracks.gz res/${FN}.n_cracks.gz
-	mv res/n_touched.gz res/${FN}.n_touched.gz
-	mv res/n_trash.gz res/${FN}.n_trash.gz
-	mv res/n_rippled.gz res/${FN}.n_rippled.gz
-	mv res/mri_t.gz res/${FN}.mri_t.gz
-	mv res/mrd_t.gz res/${FN}.mrd_t.gz
-	mv res/crack_t.gz res/${FN}.crack_t.gz
-	mv res/tree_t.gz res/${FN}.tree_t.gz
-	mv res/update_t.gz res/${FN}.update_t.gz
-	mv res/search_t.gz res/${FN}.search_t.gz
-	mv res/total_t.gz res/${FN}.total_t.gz
+	mv res/metrics.mtr res/${FN}.mtr
 	mv res/res_q res/$FN.q
 	Q=`cat res/$FN.q`
 	# echo "q = $Q"
 
-	# printf "var ${FN}_n_cracks = " >> runs.js; gunzip -c res/$FN.n_cracks.gz | bin/res_parser $Q 100 0 0 >> runs.js
-	# printf "var ${FN}_cmri_t = " >> runs.js; gunzip -c res/$FN.mri_t.gz | bin/res_parser $Q 100 1 1 >> runs.js
-	# printf "var ${FN}_cmrd_t = " >> runs.js; gunzip -c res/$FN.mrd_t.gz | bin/res_parser $Q 100 1 1 >> runs.js
-	# printf "var ${FN}_crack_t = " >> runs.js; gunzip -c res/$FN.crack_t.gz | bin/res_parser $Q 100 1 1 >> runs.js
-	# printf "var ${FN}_tree_t = " >> runs.js; gunzip -c res/$FN.tree_t.gz | bin/res_parser $Q 100 1 1 >> runs.js
-	printf "var ${FN}_cupdate_t = " >> runs.js; gunzip -c res/$FN.update_t.gz | bin/res_parser $Q 100 1 1 >> runs.js
-	printf "var ${FN}_csearch_t = " >> runs.js; gunzip -c res/$FN.search_t.gz | bin/res_parser $Q 100 1 1 >> runs.js
-	printf "var ${FN}_ctotal_t = " >> runs.js; gunzip -c res/$FN.total_t.gz | bin/res_parser $Q 100 1 1 >> runs.js
-	# printf "var ${FN}_total_t = " >> runs.js; gunzip -c res/$FN.total_t.gz | bin/res_parser $Q 100 0 1 >> runs.js
-	# printf "var ${FN}_examined = " >> runs.js; gunzip -c res/$FN.examined.gz | bin/res_parser $Q 100 0 0 >> runs.js
-	# printf "var ${FN}_trashed = " >> runs.js; gunzip -c res/$FN.n_trash.gz | bin/res_parser $Q 100 0 0 >> runs.js
-	# printf "var ${FN}_rippled = " >> runs.js; gunzip -c res/$FN.n_rippled.gz | bin/res_parser $Q 100 0 0 >> runs.js
-	# printf "var ${FN}_cexamined = " >> runs.js; gunzip -c res/$FN.examined.gz | bin/res_parser $Q 100 1 0 >> runs.js
-	# printf "var ${FN}_ctrashed = " >> runs.js; gunzip -c res/$FN.n_trash.gz | bin/res_parser $Q 100 1 0 >> runs.js
-	# printf "var ${FN}_crippled = " >> runs.js; gunzip -c res/$FN.n_rippled.gz | bin/res_parser $Q 100 1 0 >> runs.js
-	printf "var ${FN}_ctouched = " >> runs.js; gunzip -c res/$FN.n_touched.gz | bin/res_parser $Q 100 1 0 >> runs.js
+	# printf "var ${FN}_n_cracks = " >> runs.js; bin/res_parser $Q 100 0 0 res/$FN.mtr n_cracks >> runs.js
+	# printf "var ${FN}_cmri_t = " >> runs.js; bin/res_parser $Q 100 1 1 res/$FN.mtr mri_t >> runs.js
+	# printf "var ${FN}_cmrd_t = " >> runs.js; bin/res_parser $Q 100 1 1 res/$FN.mtr mrd_t >> runs.js
+	# printf "var ${FN}_crack_t = " >> runs.js; bin/res_parser $Q 100 1 1 res/$FN.mtr crack_t >> runs.js
+	# printf "var ${FN}_tree_t = " >> runs.js; bin/res_parser $Q 100 1 1 res/$FN.mtr tree_t >> runs.js
+	printf "var ${FN}_cupdate_t = " >> runs.js; bin/res_parser $Q 100 1 1 res/$FN.mtr update_t >> runs.js
+	printf "var ${FN}_csearch_t = " >> runs.js; bin/res_parser $Q 100 1 1 res/$FN.mtr search_t >> runs.js
+	printf "var ${FN}_ctotal_t = " >> runs.js; bin/res_parser $Q 100 1 1 res/$FN.mtr total_t >> runs.js
+	# printf "var ${FN}_total_t = " >> runs.js; bin/res_parser $Q 100 0 1 res/$FN.mtr total_t >> runs.js
+	# printf "var ${FN}_examined = " >> runs.js; bin/res_parser $Q 100 0 0 res/$FN.mtr examined >> runs.js
+	# printf "var ${FN}_trashed = " >> runs.js; bin/res_parser $Q 100 0 0 res/$FN.mtr n_trash >> runs.js
+	# printf "var ${FN}_rippled = " >> runs.js; bin/res_parser $Q 100 0 0 res/$FN.mtr n_rippled >> runs.js
+	# printf "var ${FN}_cexamined = " >> runs.js; bin/res_parser $Q 100 1 0 res/$FN.mtr examined >> runs.js
+	# printf "var ${FN}_ctrashed = " >> runs.js; bin/res_parser $Q 100 1 0 res/$FN.mtr n_trash >> runs.js
+	# printf "var ${FN}_crippled = " >> runs.js; bin/res_parser $Q 100 1 0 res/$FN.mtr n_rippled >> runs.js
+	printf "var ${FN}_ctouched = " >> runs.js; bin/res_parser $Q 100 1 0 res/$FN.mtr n_touched >> runs.js
 }
 
 
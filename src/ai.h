@@ -1,9 +1,115 @@
-#include "crackers.h"
+#ifndef _SCRACK_AI_H_
+#define _SCRACK_AI_H_
 
-//#define AI_IPS 1000000      // the Initial Partition Size
+#include "crackers.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <new>
+#include <thread>
 
 int USE_STOCHASTIC_AI = 1;
 
+// Storage of the final partitions, so queries rarely reach the allocator.
+// Blocks are carved front to back from slabs; a block at the end of the
+// current slab grows in place. Released blocks go on a free list per size
+// class (powers of two), linked through their first values, and are reused.
+// Slabs are only freed with the arena.
+class AI_Arena { public:
+  static const int SLAB = 1 << 20;  // values per slab; larger blocks get a slab of their own
+  static const int MIN_BLOCK = 4;   // room for a free list link
+
+  AI_Arena(): base(NULL), top(NULL), end(NULL) {
+    REP(k,32) free_list[k] = NULL;
+  }
+
+  ~AI_Arena(){
+    REP(i,slabs.size()) delete[] slabs[i];
+  }
+
+  // a block of at least cap values; cap is set to its size
+  value_type *allocate(int &cap){
+    cap = max(cap, MIN_BLOCK);
+    for (int k = ceil_log2(cap); k < 32; k++) if (free_list[k]){
+      value_type *b = free_list[k];
+      free_list[k] = link(b).next;
+      cap = link(b).size;
+      return b;
+    }
+    if (cap > SLAB / 4) return new_slab(cap);
+    if (top + cap > end){
+      release(top, end - top);
+      base = top = new_slab(SLAB);
+      end = top + SLAB;
+    }
+    value_type *b = top;
+    top += cap;
+    return b;
+  }
+
+  void release(value_type *b, int cap){
+    if (cap < MIN_BLOCK) return;
+    int k = floor_log2(cap);
+    set_link(b, free_list[k], cap);
+    free_list[k] = b;
+  }
+
+  // the block b of cap values, n of them used, grown to at least need
+  // values; cap is set to the new size
+  value_type *grow(value_type *b, int n, int &cap, int need){
+    if (b >= base && b + cap == top && b + need <= end){
+      top = b + need;
+      cap = need;
+      return b;
+    }
+    int c = need;
+    value_type *nb = allocate(c);
+    memcpy(nb, b, sizeof(value_type) * n);
+    release(b, cap);
+    cap = c;
+    return nb;
+  }
+
+private:
+  struct Link { value_type *next; int size; };
+  vector<value_type*> slabs;
+  value_type *base, *top, *end; // the current slab, [top,end) unused
+  value_type *free_list[32];    // class k: blocks of [2^k, 2^(k+1)) values
+
+  value_type *new_slab(int cap){
+    slabs.push_back(new value_type[cap]);
+    return slabs.back();
+  }
+
+  static Link link(value_type *b){  // blocks are only value aligned
+    Link l;
+    memcpy(&l, b, sizeof(Link));
+    return l;
+  }
+
+  static void set_link(value_type *b, value_type *next, int size){
+    Link l = { next, size };
+    memcpy(b, &l, sizeof(Link));
+  }
+
+  static int floor_log2(int x){ return 31 - __builtin_clz(x); }
+  static int ceil_log2(int x){ return x <= 1 ? 0 : 32 - __builtin_clz(x - 1); }
+};
+
+// the positions [from,to) of an initial partition holding the values
+// extracted from v on
+struct AI_Fetched {
+  int v, from, to;
+  AI_Fetched(int v, int from, int to): v(v), from(from), to(to) {}
+  bool operator<(int x) const { return v < x; }
+};
+
+// a contiguous part of a final partition, without holes
+struct AI_Run {
+  const value_type *arr;
+  int n;
+  AI_Run(const value_type *arr, int n): arr(arr), n(n) {}
+};
+
 class AI_Bucket { public:
   value_type *arr;
   int n;          // the element container and it's size
@@ -12,22 +118,58 @@ class AI_Bucket { public:
   int fetched;    // number of element that has been fetched to final partititons
   bool isSorted;  // is the elements in this container sorted?
   ci_type crack;  // the RBT to store the cracker piece positions and holes
-  map<int,pair<int,int> > fetchedRange;  // the cracker pieces that already fetched
+  vector<AI_Fetched> fetchedRange;  // the cracker pieces that already fetched, by value
   AI_Bucket *next;
+  value_type *sorted;          // a copy being sorted in the background, or NULL
+  atomic<bool> sorted_ready;   // the copy is sorted and can be adopted
+  AI_Arena *arena;             // where arr comes from, or NULL for new[]
 
-  AI_Bucket(int cp){
+  AI_Bucket(int cp, AI_Arena *arena = NULL): arena(arena) {
     assert(cp>0);
     crack.clear();
-    arr = new int[capacity = cp];
+    capacity = cp;
+    arr = arena ? arena->allocate(capacity) : new int[capacity];
     n = fetched = 0;
     lo = (1LL<<31)-1;
     hi = -1;
     isSorted = false;
     next = NULL;
+    sorted = NULL;
+    sorted_ready = false;
   }
 
   ~AI_Bucket(){
-    delete[] arr;
+    if (arena) arena->release(arr, capacity);
+    else delete[] arr;
+    delete[] sorted;
+  }
+
+  // room for need elements; an arena block grows by at least half
+  void reserve(int need){
+    if (need <= capacity) return;
+    if (arena){
+      arr = arena->grow(arr, n, capacity, max(need, capacity + capacity / 2));
+    } else {
+      value_type *a = new value_type[need];
+      memcpy(a, arr, sizeof(value_type) * n);
+      delete[] arr;
+      arr = a;
+      capacity = need;
+    }
+  }
+
+  // records that the positions [i1,i2) hold values extracted from v on
+  void add_fetched(int v, int i1, int i2){
+    vector<AI_Fetched>::iterator it = lower_bound(fetchedRange.begin(), fetchedRange.end(), v);
+    if (it != fetchedRange.end() && it->v == v){
+      fetched -= it->to - it->from;
+      it->from = min(it->from, i1);
+      it->to = max(it->to, i2);
+      fetched += it->to - it->from;
+      return;
+    }
+    fetchedRange.insert(it, AI_Fetched(v, i1, i2));
+    fetched += i2 - i1;
   }
 
   void insert(int x){    // append an element to this bucket
@@ -40,7 +182,7 @@ class AI_Bucket { public:
   int calc_fetched(){
     int nf = 0;
     FORE(it,fetchedRange){
-      nf += it->second.second - it->second.first;
+      nf += it->to - it->from;
     }
     return nf;
   }
@@ -49,10 +191,10 @@ class AI_Bucket { public:
     if (crack.empty()) return;
     int i = -1, j = -1, nf = 0;
     FORE(it,fetchedRange){
-      if (i == -1) i = it->second.first;
-      else while (j < it->second.first) arr[i++] = arr[j++];
-      j = it->second.second;
-      nf += it->second.second - it->second.first;
+      if (i == -1) i = it->from;
+      else while (j < it->from) arr[i++] = arr[j++];
+      j = it->to;
+      nf += it->to - it->from;
     }
     if (j!=-1) while (j < n) arr[i++] = arr[j++];
     n = i;
@@ -63,7 +205,16 @@ class AI_Bucket { public:
     assert(!isSorted);
   }
 
+  // about how many tuples index<USE_CRACKING, ...>(v) reads
   template <bool USE_CRACKING>
+  int index_cost(int v){
+    if (!USE_CRACKING) return isSorted ? 0 : n;
+    int L,R;
+    find_piece(crack,n,v,L,R);
+    return R - L;
+  }
+
+  template <bool USE_CRACKING, int CRACK_AT>
   int index(int v, int &examined){            // find the index of this value
     if (USE_CRACKING){                        // find using cracking
       int L,R; 
@@ -87,22 +238,108 @@ class AI_Bucket { public:
       return lower_bound(arr,arr+n,v) - arr;  // binary search through it
     }
   }
+
+  // index<USE_CRACKING>(v) for a bucket already indexed on v, without
+  // stochastic cracks: the crack on v, else the piece holding v (merging
+  // updates can drop the crack) is cracked on v again.
+  // The holes in front of the position are included.
+  template <bool USE_CRACKING>
+  int position(int v, int &examined){
+    if (!USE_CRACKING) return index<false, 0>(v,examined);
+    ci_iter it = crack.find(v);
+    if (it != crack.end()) return it->second.pos;
+    int L,R;
+    find_piece(crack,n,v,L,R);
+    examined += R - L;
+    return add_crack(crack, n, v, partition(arr,v,L,R));
+  }
+
+  // replaces the (cracked) elements by the sorted copy. A fetched range
+  // holds the values [v1,v2) of its extractions, which in sorted order
+  // start at the lower bound of v1
+  void adopt_sorted(){
+    FORE(it,fetchedRange){
+      int len = it->to - it->from;
+      it->from = lower_bound(sorted,sorted+n,it->v) - sorted;
+      it->to = it->from + len;
+    }
+    delete[] arr;
+    arr = sorted;
+    sorted = NULL;
+    crack.clear();
+    isSorted = true;
+  }
+
+  // appends the positions [i1,i2) of values v1 and v2 as runs, split around
+  // the holes deletes left in front of the cracks between them; returns
+  // their total length
+  int add_runs(int v1, int v2, int i1, int i2, vector<AI_Run> &runs){
+    int from = i1, cnt = 0;
+    for (ci_iter it = crack.upper_bound(v1); it != crack.end() && it->first <= v2 && it->second.pos <= i2; it++){
+      if (!it->second.holes || it->second.pos <= i1) continue;
+      int to = max(from, it->second.prev_pos());
+      if (from < to) runs.push_back(AI_Run(arr + from, to - from)), cnt += to - from;
+      from = it->second.pos;
+    }
+    if (from < i2) runs.push_back(AI_Run(arr + from, i2 - from)), cnt += i2 - from;
+    return cnt;
+  }
 };
 
 bool buk_size_cmp(AI_Bucket *x, AI_Bucket *y) {
   return x->n > y->n;
 }
 
+// CRACK_AT: stochastic cracks split pieces larger than this
+// COMPACT_EVERY: initial partitions are compacted every this many queries
+// AI_IPS: the Initial Partition Size
+template <int CRACK_AT, int COMPACT_EVERY, int AI_IPS>
 class AI {
+  typedef pair<int,AI_Bucket*> FP;
+  static const int HEADERS = 256;  // final partition headers per block
+
   multiset<int> pending_insert, pending_delete;  // pending updates (insert / delete)
-  map<int,AI_Bucket*> fp; // final partitions orderings
+  vector<FP> fp;          // final partitions by smallest value, sorted
   vector<AI_Bucket*> IP;  // the unsorted initial partitions
   int nth_query;          // a counter how many queries has elapsed
+  vector<thread> sorters; // sort the initial partitions in the background
+  atomic<int> next_sort;  // the next initial partition to sort
+  atomic<bool> stop_sorting;
+  int unsorted;           // initial partitions whose sorted copy is not adopted yet
+  AI_Arena arena;         // the final partitions' values
+  vector<AI_Bucket*> headers;  // blocks of HEADERS final partitions, the last one filling
+  int headers_used;            // in the last block
+  vector<int> from, to, ex, at, lo, hi;  // extract's per partition scratch
+  vector<AI_Bucket*> prev;                      // scan_holes' scratch
   
-  typedef map<int,AI_Bucket*>::iterator mit;
+  typedef vector<FP>::iterator mit;
+
+  static bool fp_less(const FP &p, int v){ return p.first < v; }
+
+  mit fp_lower_bound(int v){
+    return lower_bound(fp.begin(), fp.end(), v, fp_less);
+  }
+
+  // indexes the final partition b starting at v; iterators into fp are
+  // invalidated
+  mit fp_insert(int v, AI_Bucket *b){
+    mit it = fp_lower_bound(v);
+    assert(it == fp.end() || it->first != v);  // the index holds the smallest element
+    return fp.insert(it, FP(v, b));
+  }
+
+  // a final partition with room for cp values, its header carved from a
+  // block of them
+  AI_Bucket *new_fp(int cp){
+    if (headers.empty() || headers_used == HEADERS){
+      headers.push_back(static_cast<AI_Bucket*>(::operator new(sizeof(AI_Bucket) * HEADERS)));
+      headers_used = 0;
+    }
+    return new (headers.back() + headers_used++) AI_Bucket(cp, &arena);
+  }
 
   mit f(int v){
-    mit it = fp.lower_bound(v); // handling off by one search
+    mit it = fp_lower_bound(v); // handling off by one search
     if (it == fp.end()){ if (it != fp.begin()) it--; }
     else if (it == fp.begin()){}
     else if (it->first > v){ it--; }
@@ -119,37 +356,77 @@ class AI {
     }
   }
   
-  // copy all values [v1,v2) from initial partitions to a final partition 
+  // copy all values [v1,v2) from initial partitions to a final partition.
+  // The initial partitions are indexed on v1 and v2 in parallel, then the
+  // values are copied to their offsets in the new bucket, in partition order
+  // as before. Small extractions and the stochastic variants run in this
+  // thread: the latter's rand() calls must keep their order.
   template <int VARIANT>  // 0 = CRACK CRACK, 1 = CRACK SORT, 2 = SORT SORT (this happens during compile time!)
   AI_Bucket* extract(int v1, int v2){
-    vector<value_type> t;
-    REP(i,IP.size()){
-      int i1 = IP[i]->index<VARIANT!=2>(v1,examined);
-      int i2 = IP[i]->index<VARIANT!=2>(v2,examined);
-      if (IP[i]->fetchedRange.count(v1)){
-        pair<int,int> &p = IP[i]->fetchedRange[v1];
-        IP[i]->fetched -= p.second - p.first;
-        p.first = min(p.first, i1);
-        p.second = max(p.second, i2);
-        IP[i]->fetched += p.second - p.first;
+    const int PARALLEL_WORK = 1 << 16;  // tuples to read before fanning out
+    int nip = IP.size();
+    ThreadPool &pool = ThreadPool::shared();
+    bool parallel = nip > 1 && pool.size() > 1 && ((VARIANT == 2 && !unsorted) || !USE_STOCHASTIC_AI);
+    if (parallel){
+      long long work = 0;
+      REP(i,nip) work += IP[i]->sorted ? IP[i]->index_cost<true>(v1) + IP[i]->index_cost<true>(v2)
+        : IP[i]->index_cost<VARIANT!=2>(v1) + IP[i]->index_cost<VARIANT!=2>(v2);
+      parallel = work >= PARALLEL_WORK;
+    }
+
+    from.resize(nip);
+    to.resize(nip);
+    ex.assign(nip, 0);
+    auto locate = [&](int i){
+      AI_Bucket *p = IP[i];
+      int i1, i2;
+      if (VARIANT == 2 && p->sorted){  // not sorted yet: crack it meanwhile
+        i1 = from[i] = p->index<true, CRACK_AT>(v1,ex[i]);
+        i2 = to[i] = p->index<true, CRACK_AT>(v2,ex[i]);
       } else {
-        IP[i]->fetchedRange[v1] = make_pair(i1,i2);
-        IP[i]->fetched += i2 - i1;
+        i1 = from[i] = p->index<VARIANT!=2, CRACK_AT>(v1,ex[i]);
+        i2 = to[i] = p->index<VARIANT!=2, CRACK_AT>(v2,ex[i]);
       }
+      p->add_fetched(v1,i1,i2);
       assert(i1 <= i2);
-      while (i1 < i2) t.push_back(IP[i]->arr[i1++]);
+    };
+    if (parallel) pool.run(nip, locate);
+    else REP(i,nip) locate(i);
+
+    at.assign(nip+1, 0);  // where each partition's values go
+    REP(i,nip){
+      examined += ex[i];
+      at[i+1] = at[i] + to[i] - from[i];
+    }
+    if (!at[nip]) return NULL;
+    AI_Bucket *b = new_fp(at[nip]*2+100);  // creates a final partition
+
+    lo.assign(nip, b->lo);
+    hi.assign(nip, b->hi);
+    auto copy = [&](int i){
+      const value_type *src = IP[i]->arr;
+      value_type *dst = b->arr + at[i] - from[i];
+      for (int j=from[i]; j<to[i]; j++){
+        dst[j] = src[j];
+        lo[i] = min(lo[i], src[j]);
+        hi[i] = max(hi[i], src[j]);
+      }
+    };
+    if (parallel && at[nip] >= PARALLEL_WORK) pool.run(nip, copy);
+    else REP(i,nip) copy(i);
+    REP(i,nip){
+      b->lo = min(b->lo, lo[i]);
+      b->hi = max(b->hi, hi[i]);
     }
-    if (!t.size()) return NULL;
-    AI_Bucket *b = new AI_Bucket(t.size()*2+100);  // creates a final partition
-    REP(i,t.size()) b->insert(t[i]);
+    b->n = at[nip];
     assert(b->n > 0);
-    assert(!fp.count(v1));  // the tree will index the smallest element
-    return fp[v1] = b;      // index the final partition order
+    fp_insert(v1, b);       // index the final partition order
+    return b;
   }
 
   template <int VARIANT>    // 0 = CRACK CRACK, 1 = CRACK SORT, 2 = SORT SORT (this happens during compile time!)
   void scan_holes(int v1, int v2){
-    vector<AI_Bucket*> prev;
+    prev.clear();
     mit it = f(v1);
     assert(it != fp.end());
     AI_Bucket *b = it->second;
@@ -159,48 +436,45 @@ class AI {
         b = b->next;  // one jump is enough
       }
       if (b->hi+1 >= v2) break;
-      it = fp.lower_bound(b->hi+1);
+      it = fp_lower_bound(b->hi+1);
       AI_Bucket *nb = NULL;
       if (it==fp.end()){
         nb = extract<VARIANT>(b->hi+1,v2);
         if (!nb) break;
         assert(nb);
       } else if (it->first != b->hi+1){
+        AI_Bucket *above = it->second;  // extract moves it
         nb = extract<VARIANT>(b->hi+1,it->first);
-        if (!nb) nb = it->second;
+        if (!nb) nb = above;
       } else {
         nb = it->second;
       }
       b->next = nb;
     }
     REP(i,prev.size()) prev[i]->next = b;
-    b->index<VARIANT==0>(v2,examined);
+    b->index<VARIANT==0, CRACK_AT>(v2,examined);
   }
 
-  value_type* reallocate(value_type *a, int n, int cap){
-    assert(n<=cap);
-    value_type *b = new value_type[cap];
-    memcpy(b,a,sizeof(value_type)*n);
-    delete[] a;
-    return b;
-  }
-  
   void scan_updates(int v1, int v2){
     mit it = f(v1);
-    assert(it != fp.end());
+    // inserts below the first final partition, where the initial partitions
+    // had nothing to extract, start a final partition of their own
+    value_type below = it == fp.end() ? v2 : min(v2, it->first);
+    if (v1 < below && pending_insert.lower_bound(v1) != pending_insert.lower_bound(below))
+      it = fp_insert(v1, new_fp(1));
+    if (it == fp.end()) return;
     while (it != fp.end() && it->first < v2){
       AI_Bucket *b = it->second;
       value_type x = it->first;
       value_type y = v2;
       it++;
       if (it != fp.end() && it->first < v2) y = it->first;
-      int need = b->n + pending_insert.size();
-      if (need >= b->capacity){
-        b->arr = reallocate(b->arr, b->n, need);
-        b->capacity = need;
-      }
+      b->reserve(b->n + pending_insert.size());
+      size_t pending = pending_insert.size() + pending_delete.size();
       b->hi = max(b->hi, merge_ripple(b->crack,b->arr,b->n,pending_insert,pending_delete,x,y));
       assert(b->n <= b->capacity);
+      // merges append to the bucket, a sorted one has to be sorted again
+      if (pending != pending_insert.size() + pending_delete.size()) b->isSorted = false;
     }
   }
 
@@ -236,16 +510,34 @@ class AI {
         scan_holes<VARIANT>(v1,v2);
       }
     } else {
-      it->second->index<VARIANT==0>(v1,examined);
+      it->second->index<VARIANT==0, CRACK_AT>(v1,examined);
       scan_holes<VARIANT>(v1,v2);
     }
   }
 
+  // swaps in the initial partitions sorted in the background since the
+  // last query, or all of them once sorted when wait is set
+  void adopt_sorted(bool wait){
+    if (wait) stop_sorters();
+    unsorted = 0;
+    REP(i,IP.size()) if (IP[i]->sorted){
+      if (IP[i]->sorted_ready.load(memory_order_acquire)) IP[i]->adopt_sorted();
+      else unsorted++;
+    }
+    if (!unsorted) stop_sorters();
+  }
+
+  void stop_sorters(){
+    REP(t,sorters.size()) sorters[t].join();
+    sorters.clear();
+  }
+
   void do_ip_compaction(){
     int tn=0, tf=0;
     REP(i,IP.size()) tn += IP[i]->n, tf += IP[i]->fetched;
     if (tf < tn / 2) return;
     
+    if (unsorted) adopt_sorted(true);  // the partitions move below
     REP(i,IP.size()) IP[i]->compact();
     sort(IP.begin(), IP.end(), buk_size_cmp);
     int i=0, j=IP.size()-1;
@@ -270,6 +562,7 @@ class AI {
   template<int VARIANT> // 0 = CRACK CRACK, 1 = CRACK SORT, 2 = SORT SORT (this happens during compile time!)
   int select(value_type v1, value_type v2, value_type *marr){
     nth_query++;
+    if (unsorted) adopt_sorted(false);
     if (IP.size() > 1 && nth_query % COMPACT_EVERY == 0) do_ip_compaction();
     
     crack_t.start();
@@ -278,59 +571,79 @@ class AI {
 
     scan_updates(v1,v2);
     
-    int midx = 0;
+    // the result: the runs of each final partition overlapping [v1,v2),
+    // around the holes deleted tuples left
+    result.clear();
+    int cnt = 0;
+    for (mit it = f(v1); it != fp.end() && it->first < v2; it++){
+      AI_Bucket *b = it->second;
+      int i1 = v1 <= it->first ? 0 : b->position<VARIANT==0>(v1,examined);
+      int i2 = v2 > b->hi ? b->n : b->position<VARIANT==0>(v2,examined);
+      if (i1 < i2) cnt += b->add_runs(v1,v2,i1,i2,result);
+    }
     #ifdef DEBUG  // materialize and check the result for debugging
-      mit it = f(v1);
-      // TODO
-      if (it!=fp.begin()) it--; // it could be that the result spoiled to the prev bucket!
-      assert(it!=fp.end());
-      if (v2 > it->second->hi){
-        int i = it->second->index<VARIANT==0>(v1,examined);
-        for (; i < it->second->n; i++)
-          if (it->second->arr[i] > 0)
-            marr[midx++] = it->second->arr[i];
-        for (it++; it!=fp.end() && v2 > it->first; it++){
-          if (v2 <= it->second->hi) break;
-          int j = it->second->index<VARIANT==0>(v1,examined);
-          for (; j < it->second->n; j++)
-            if (it->second->arr[j]>0 && it->second->arr[j] < v2)
-              marr[midx++] = it->second->arr[j];
-        }
-        if (it!=fp.end()){
-          int i1 = it->second->index<VARIANT==0>(v1,examined),
-            i2 = it->second->index<VARIANT==0>(v2,examined);
-          for (int j=i1; j<i2; j++)
-            if (it->second->arr[j]>0) marr[midx++] = it->second->arr[j];
-        }
-      } else {
-        int i = it->second->index<VARIANT==0>(v1,examined);
-        int j = it->second->index<VARIANT==0>(v2,examined);
-        for (int k=i; k<j; k++) if (it->second->arr[k]>0)
-          marr[midx++] = it->second->arr[k];
+      int midx = 0;
+      REP(r,result.size()) REP(j,result[r].n){
+        value_type v = result[r].arr[j];
+        assert(v >= v1 && v < v2);
+        marr[midx++] = v;
       }
+      assert(midx == cnt);
     #endif
-    return midx;
+    return cnt;
   }
 
 public :
   int examined;      // the number of examined tuples in a query
+  vector<AI_Run> result;  // the last query's result, in value order
   
-  AI(){}
+  AI(): nth_query(0), next_sort(0), stop_sorting(false), unsorted(0), headers_used(0) {
+    fp.reserve(1024);
+    headers.reserve(64);
+  }
   
   void init(int *arr, int n){            // creates initial partitions on the given aray and its size
     int j=0, nb = (n+AI_IPS-1) / AI_IPS;  // calculate the number of needed initial partitions
     IP.resize(nb);
     REP(i,nb){
       IP[i] = new AI_Bucket(AI_IPS);    // create an partition
+      IP[i]->fetchedRange.reserve(64);
       REP(k,min(n-j,AI_IPS))        // fill it with parts of the arr
         IP[i]->insert(arr[j++]);  
     }
     assert(j==n);              // sanity check that everything is inserted
   }
 
+  // sorts copies of the initial partitions on SCRACK_THREADS background
+  // threads, right after init. Until its copy is adopted SORT SORT cracks a
+  // partition instead of sorting it on the query thread, so the first
+  // queries stay cheap. With one thread the partitions are sorted on first
+  // touch as before.
+  void sort_in_background(){
+    int nip = IP.size(), threads = min(nip, ThreadPool::default_threads());
+    if (ThreadPool::default_threads() <= 1 || !sorters.empty()) return;
+    REP(i,nip){
+      AI_Bucket *p = IP[i];
+      p->sorted = new value_type[p->capacity];
+      memcpy(p->sorted, p->arr, p->n * sizeof(value_type));
+    }
+    unsorted = nip;
+    next_sort = 0;
+    REP(t,threads) sorters.push_back(thread([this, nip]{
+      for (int i; !stop_sorting && (i = next_sort.fetch_add(1)) < nip; ){
+        AI_Bucket *p = IP[i];
+        sort(p->sorted, p->sorted + p->n);
+        p->sorted_ready.store(true, memory_order_release);
+      }
+    }));
+  }
+
   ~AI(){  // destructor
+    stop_sorting = true;
+    stop_sorters();
     REP(i,IP.size()) delete IP[i];      // delete all initial partitions
-    FORE(i,fp) delete i->second;      // delete all final partitions
+    FORE(i,fp) i->second->~AI_Bucket();  // delete all final partitions
+    REP(i,headers.size()) ::operator delete(headers[i]);
   }
   
   void insert(int v){
@@ -354,6 +667,7 @@ public :
     return select<1>(v1,v2,marr);
   }
   int sort_sort(int v1, int v2, int *marr){
+    USE_STOCHASTIC_AI = 0;  // partitions cracked until their sorted copy is in
     return select<2>(v1,v2,marr);
   }
   
@@ -366,3 +680,5 @@ public :
     return select<1>(v1,v2,marr);
   }
 };
+
+#endif
@@ -0,0 +1,206 @@
+// One benchmark driver for all the algorithms. Each algorithm is a class
+// template over its tuning parameters (crack at, max cracks, percentage,
+// ...); the configurations of the experiments are instantiated below and
+// picked by name at runtime.
+//
+//   bench list
+//       the algorithm names
+//   bench ALGORITHMS INPUT Q SELECTIVITIES QUERY-WORKLOADS UPDATE-WORKLOADS view|count TLE
+//       every combination of the comma separated lists, in one process on
+//       one mapping of INPUT (restored between runs); res/ gets one metrics
+//       file per run, named like run.sh's: ALGO_DATA_SEL_WORK_UPDT_RET.mtr
+//       (and .q with the number of queries run)
+//
+// Invoked under an algorithm's name (the makefile links bin/<name> to
+// bench), it is the single experiment harness those binaries always were:
+//
+//   bin/ddc128 INPUT Q SELECTIVITY QUERY-WORKLOAD UPDATE-WORKLOAD view|count TLE [STREAMS]
+//
+// writing res/metrics.mtr and res/res_q.
+
+#include "tester.h"
+#include "sort.cpp"
+#include "scan.cpp"
+#include "crack.cpp"
+#include "ddc.cpp"
+#include "ddr.cpp"
+#include "dd1rs.cpp"
+#include "mdd1r.cpp"
+#include "mdd1rp.cpp"
+#include "selective.cpp"
+#include "ai.cpp"
+#include "engine.cpp"
+#include <string>
+#include <vector>
+#include <new>
+#include <stdlib.h>
+
+// Replaces the global operator new to count heap allocations for the n_allocs
+// metrics column, on every thread, including the workers a query fans out to
+// and aiss's background sorters. Not inlined, or GCC takes the free() for a
+// mismatched deallocation.
+std::atomic<long long> heap_allocs(0);
+
+__attribute__((noinline)) void *operator new(size_t n){
+  heap_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (n == 0) n = 1;
+  for (;;){
+    if (void *p = malloc(n)) return p;
+    std::new_handler h = std::get_new_handler();
+    if (!h) throw std::bad_alloc();
+    h();
+  }
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { free(p); }
+
+template <class A> Algorithm *make(){ return new A; }
+
+struct Entry {
+  const char *name;
+  Algorithm *(*make)();
+} ALGORITHMS[] = {
+  { "sort", make<Sort> },
+  { "scan", make<Scan> },
+  { "crack", make<Crack<0,0> > },
+  { "naive_r1x", make<Crack<1,0> > },
+  { "naive_r2x", make<Crack<2,0> > },
+  { "naive_r4x", make<Crack<4,0> > },
+  { "naive_r1th", make<Crack<0,1> > },
+  { "naive_r2th", make<Crack<0,2> > },
+  { "naive_r4th", make<Crack<0,4> > },
+  { "naive_r8th", make<Crack<0,8> > },
+  { "dd1c", make<DDC<1,128> > },
+  { "ddc32", make<DDC<1000,32> > },
+  { "ddc64", make<DDC<1000,64> > },
+  { "ddc128", make<DDC<1000,128> > },
+  { "ddc256", make<DDC<1000,256> > },
+  { "ddc512", make<DDC<1000,512> > },
+  { "ddc1024", make<DDC<1000,1024> > },
+  { "ddcL2", make<DDC<1000,4096> > },
+  { "ddc8192", make<DDC<1000,8192> > },
+  { "ddc1M", make<DDC<1000,1000000> > },
+  { "ddc10M", make<DDC<1000,10000000> > },
+  { "ddc", make<DDC<1000,128> > },
+  { "dd1rs", make<DD1RS<128> > },
+  { "dd1r", make<DDR<1,128> > },
+  { "ddr128", make<DDR<1000,128> > },
+  { "ddr1024", make<DDR<1000,1024> > },
+  { "ddr8192", make<DDR<1000,8192> > },
+  { "ddr", make<DDR<1000,128> > },
+  { "mdd1r", make<MDD1R<0> > },
+  { "mdd1r1k", make<MDD1R<1000> > },
+  { "mdd1r10k", make<MDD1R<10000> > },
+  { "mdd1r100k", make<MDD1R<100000> > },
+  { "mdd1r1m", make<MDD1R<1000000> > },
+  { "mdd1rp1", make<MDD1RP<1> > },
+  { "mdd1rp5", make<MDD1RP<5> > },
+  { "mdd1rp10", make<MDD1RP<10> > },
+  { "mdd1rp50", make<MDD1RP<50> > },
+  { "mdd1rp100", make<MDD1RP<100> > },
+  { "mdd1rp", make<MDD1RP<10> > },
+  { "selective50p", make<Selective<0,50> > },
+  { "selective20p", make<Selective<0,20> > },
+  { "selective80p", make<Selective<0,80> > },
+  { "selective2d", make<Selective<2,0> > },
+  { "selective10d", make<Selective<10,0> > },
+  { "selective100d", make<Selective<100,0> > },
+  { "aicc1k", make<Hybrid<AICC,128,1000,1000000> > },
+  { "aicc", make<Hybrid<AICC,128,1000000000,1000000> > },
+  { "aics", make<Hybrid<AICS,128,1000000000,1000000> > },
+  { "aiss", make<Hybrid<AISS,128,1000000000,1000000> > },
+  { "aicc1r", make<Hybrid<AICC1R,128,1000000000,1000000> > },
+  { "aics1r", make<Hybrid<AICS1R,128,1000000000,1000000> > },
+  { "aiccrp2", make<Hybrid<AICCRP2,128,1000000000,1000000> > },
+  { "aiccrmsz1m", make<Hybrid<AICCRMSZ,128,1000000000,1000000,1000000> > },
+  { "engine", make<Engine<crackstore::CrackingEngine> > },
+  { "engine_am", make<Engine<crackstore::AdaptiveMergingEngine> > },
+  { "engine_tuned", make<Engine<TunedCrackingEngine> > },
+};
+const int NALGORITHMS = sizeof(ALGORITHMS) / sizeof(ALGORITHMS[0]);
+
+const Entry *find_algorithm(const string &name){
+  REP(i,NALGORITHMS) if (name == ALGORITHMS[i].name) return &ALGORITHMS[i];
+  return NULL;
+}
+
+vector<string> split(const char *list){
+  vector<string> res;
+  string s = list;
+  for (size_t i=0, j; i<=s.size(); i=j+1){
+    j = s.find(',', i);
+    if (j == string::npos) j = s.size();
+    if (j > i) res.push_back(s.substr(i, j-i));
+  }
+  return res;
+}
+
+void write_q(const char *fn, int Q){
+  FILE *QF = fopen(fn,"w");
+  if (!QF){ fprintf(stderr,"Cannot write %s\n",fn); exit(1); }
+  fprintf(QF,"%d\n",Q);
+  fclose(QF);
+}
+
+// the harness of bin/<algorithm>
+int run_single(const Entry *e, int argc, char *argv[]){
+  if (argc < 8){
+    fprintf(stderr,"usage: %s [input-file] [num of queries] [selectivity] [query workload] [update workload] [view|count] [time limit] [query streams]\n", argv[0]);
+    exit(1);
+  }
+  int streams = argc > 8 ? atoi(argv[8]) : 1;
+  if (streams < 1){ fprintf(stderr,"Invalid number of query streams: %s\n",argv[8]); exit(1); }
+
+  DataFile input;
+  input.open(argv[1]);
+  Algorithm *A = e->make();
+  int Q = run_experiment(*A, argv[0], input, atoi(argv[2]), argv[3], argv[4], argv[5], argv[6], atoi(argv[7]),
+      streams, "res/metrics.mtr");
+  delete A;
+  write_q("res/res_q", Q);
+  return 0;
+}
+
+int run_matrix(int argc, char *argv[]){
+  vector<string> algorithms = split(argv[1]), sels = split(argv[4]), works = split(argv[5]), updts = split(argv[6]);
+  REP(i,algorithms.size()) if (!find_algorithm(algorithms[i])){
+    fprintf(stderr,"Unknown algorithm \"%s\" (see %s list)\n", algorithms[i].c_str(), argv[0]);
+    exit(1);
+  }
+  string data = argv[2];
+  data = data.substr(data.rfind('/') + 1);
+  int Q = atoi(argv[3]), TLE = atoi(argv[8]);
+
+  DataFile input;
+  input.open(argv[2]);
+  REP(a,algorithms.size()) REP(w,works.size()) REP(s,sels.size()) REP(u,updts.size()){
+    string work = works[w];
+    replace(work.begin(), work.end(), '/', '_');   // trace:dir/file
+    string fn = "res/" + algorithms[a] + "_" + data + "_" + sels[s] + "_" + work + "_" + updts[u] + "_" + argv[7];
+    Algorithm *A = find_algorithm(algorithms[a])->make();
+    int q = run_experiment(*A, algorithms[a].c_str(), input, Q, sels[s].c_str(), &works[w][0], &updts[u][0],
+        argv[7], TLE, 1, (fn + ".mtr").c_str());
+    delete A;
+    write_q((fn + ".q").c_str(), q);
+    input.restore();
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]){
+  string self = argv[0];
+  const Entry *e = find_algorithm(self.substr(self.rfind('/') + 1));
+  if (e) return run_single(e, argc, argv);
+
+  if (argc == 2 && !strcmp(argv[1],"list")){
+    REP(i,NALGORITHMS) printf("%s\n", ALGORITHMS[i].name);
+    return 0;
+  }
+  if (argc != 9){
+    fprintf(stderr,"usage: %s list\n"
+        "       %s [algorithms] [input-file] [num of queries] [selectivities] [query workloads] [update workloads] [view|count] [time limit]\n"
+        "(lists are comma separated)\n", argv[0], argv[0]);
+    exit(1);
+  }
+  return run_matrix(argc, argv);
+}
@@ -1,3 +1,6 @@
+#ifndef _SCRACK_CRACKERS_H_
+#define _SCRACK_CRACKERS_H_
+
 #include <map>
 #include <set>
 #include <vector>
@@ -443,7 +446,8 @@ void do_merge_ripple_delete(ci_type &ci, value_type *arr, int &N, multiset<int>
   get_pendings(ci,a,b,it1,it2,pending_delete,pDel);
   n_trash += pDel.size();
 
-  Hash h(pDel.size()); // prepare for Hash JOIN
+  static thread_local HashMultiset<value_type> h;  // for the Hash JOIN, reused across calls
+  h.reset(pDel.size());
 
   // MRD all tuples in [ arr[L1], arr[R2] )
   int deli = 0;
@@ -454,8 +458,7 @@ void do_merge_ripple_delete(ci_type &ci, value_type *arr, int &N, multiset<int>
       // hash the pending deletes for this piece
       int toDelete = 0;
       while (deli < int(pDel.size()) && pDel[deli] < it1->first){
-        int v = h.get(pDel[deli]);
-        h.set(pDel[deli], (v>0)? (v+1) : 1);
+        h.add(pDel[deli]);
         toDelete++;
         deli++;
       }
@@ -464,9 +467,7 @@ void do_merge_ripple_delete(ci_type &ci, value_type *arr, int &N, multiset<int>
       int R = it1->second.prev_pos();
       while (L1 < R && toDelete){
         assert(arr[L1]>=0);
-        int v = h.get(arr[L1]);
-        if (v > 0){
-          h.set(arr[L1], v-1);
+        if (h.take(arr[L1])){
           arr[L1] = arr[--R];
           arr[R] = -1;
           it1->second.holes++;  // increase hole size
@@ -498,8 +499,7 @@ void do_merge_ripple_delete(ci_type &ci, value_type *arr, int &N, multiset<int>
     // hash the pending deletes for this piece
     int toDelete = 0;
     while (deli < int(pDel.size())){
-      int v = h.get(pDel[deli]);
-      h.set(pDel[deli], (v>0)? (v+1) : 1);
+      h.add(pDel[deli]);
       toDelete++;
       deli++;
     }
@@ -511,9 +511,7 @@ void do_merge_ripple_delete(ci_type &ci, value_type *arr, int &N, multiset<int>
         fprintf(stderr,"L1 = %d\n",L1);
       }
       assert(arr[L1]>0);
-      int v = h.get(arr[L1]);
-      if (v > 0){
-        h.set(arr[L1], v-1);
+      if (h.take(arr[L1])){
         arr[L1] = arr[--N];
         arr[N] = -1;
         toDelete--;
@@ -599,3 +597,5 @@ int targeted_random_crack3(ci_type &ci, value_type v, value_type *arr, int &N, i
   }
   return add_crack(ci, N, v, partition(arr, v, L,R));
 }
+
+#endif
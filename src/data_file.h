@@ -0,0 +1,123 @@
+#ifndef _SCRACK_DATA_FILE_H_
+#define _SCRACK_DATA_FILE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Binary input files of native ints, mapped instead of read. The mapping is
+// private and writable: pages come from the page cache on first touch and
+// are only copied when the harness modifies them (ROLL, DELETE, updates),
+// so startup costs nothing and concurrent experiments on the same file
+// share memory.
+//
+// With SCRACK_HUGEPAGES=1 in the environment the data is instead copied
+// into an anonymous mapping backed by huge pages (MAP_HUGETLB if the pool
+// has room, else transparent huge pages), which cuts TLB misses on large
+// working arrays.
+//
+// restore() undoes the harness's modifications, so one process can run
+// several experiments on the file contents.
+//
+// A file may start with a DataHeader (gen_data --header), which says how it
+// was generated; headerless files are plain arrays of 32-bit values.
+
+struct DataHeader {		// 64 bytes, little-endian
+	char magic[8];		// "SCRKDAT1"
+	int32_t value_bytes;	// 4 or 8
+	int32_t header_bytes;	// sizeof(DataHeader); the values follow
+	int64_t n;
+	int64_t seed;
+	char distribution[16];
+	double param;		// the distribution's parameter, 0 if none
+	char reserved[8];
+};
+
+class DataFile { public:
+	int *data;
+	size_t n;
+	DataHeader header;	// all zero for a headerless file
+
+	DataFile(): data(0), n(0), map(0), map_bytes(0), copy(0), copy_bytes(0) {}
+	~DataFile(){
+		if (map) munmap(map, map_bytes);
+		if (copy) munmap(copy, copy_bytes);
+	}
+
+	// maps the file, exits with a message on failure
+	void open(const char *fn){
+		int fd = ::open(fn, O_RDONLY);
+		if (fd < 0){ fprintf(stderr,"Error opening file %s\n",fn); exit(1); }
+		struct stat st;
+		if (fstat(fd, &st) != 0){ perror("fstat"); exit(1); }
+		if (st.st_size < (off_t) sizeof(int)){ fprintf(stderr,"Data file %s is empty\n",fn); exit(1); }
+		map_bytes = st.st_size;
+
+		void *p = mmap(0, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED){ perror("mmap"); fprintf(stderr,"Error mapping %s!\n",fn); exit(1); }
+		map = (char*) p;
+		madvise(map, map_bytes, MADV_SEQUENTIAL);	// init() scans it front to back
+
+		size_t skip = 0;
+		memset(&header, 0, sizeof header);
+		if (map_bytes >= sizeof header && !memcmp(map, "SCRKDAT1", 8)){
+			memcpy(&header, map, sizeof header);
+			if (header.value_bytes != sizeof(int)){
+				fprintf(stderr,"Data file %s has %d-byte values, the harness needs %d\n",fn,header.value_bytes,(int) sizeof(int));
+				exit(1);
+			}
+			skip = header.header_bytes;
+		}
+		n = (map_bytes - skip) / sizeof(int);
+		if (n == 0){ fprintf(stderr,"Data file %s is empty\n",fn); exit(1); }
+		data = (int*) (map + skip);
+
+		const char *env = getenv("SCRACK_HUGEPAGES");
+		if (env && atoi(env)) to_hugepages();
+	}
+
+	// brings data back to the file contents
+	void restore(){
+		if (copy) memcpy(data, values(), n * sizeof(int));	// huge pages: copy again
+		else madvise(map, map_bytes, MADV_DONTNEED);	// drops the modified private pages
+	}
+
+	// replaces the file mapping with an anonymous huge page copy; the
+	// mapping is kept (untouched) for restore()
+	void to_hugepages(){
+		const size_t HUGE_PAGE = 2 << 20, bytes = n * sizeof(int);
+		size_t len = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+		void *p = mmap(0, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p == MAP_FAILED){
+			// no reserved huge pages: over-allocate so the region can be
+			// 2MB aligned, which transparent huge pages require
+			char *q = (char*) mmap(0, len + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (q == MAP_FAILED){ perror("mmap"); return; }	// keep the file mapping
+			char *aligned = (char*) (((size_t) q + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE);
+			if (aligned > q) munmap(q, aligned - q);
+			munmap(aligned + len, q + HUGE_PAGE - aligned);
+			p = aligned;
+			madvise(p, len, MADV_HUGEPAGE);
+		}
+		memcpy(p, data, bytes);
+		data = (int*) p;
+		copy = (char*) p;
+		copy_bytes = len;
+	}
+
+private:
+	char *map;		// the file mapping
+	size_t map_bytes;
+	char *copy;		// the huge page copy, if any
+	size_t copy_bytes;
+
+	int *values(){ return (int*) (map + (header.value_bytes ? header.header_bytes : 0)); }
+};
+
+#endif
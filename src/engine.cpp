@@ -0,0 +1,61 @@
+#include "tester.h"       // the Algorithm interface
+#include "distributed/core/cracking_engine.h"
+#include "distributed/core/adaptive_merging_engine.h"
+
+// The distributed storage nodes' column engines behind the tester interface,
+// so they run the same experiments as crack.cpp and ai.cpp (single or
+// concurrent query streams). The engines are not internally synchronized;
+// the tester serializes calls to them as a storage node's column lock does.
+
+// the cracking engine takes the column's spare capacity
+crackstore::CrackingEngine *new_engine(crackstore::CrackingEngine*, int *a, int n, int cap){
+  return new crackstore::CrackingEngine(a, n, cap - n);
+}
+// the cracking engine picking its stochastic cracks per query (crack_tuner.h)
+struct TunedCrackingEngine : crackstore::CrackingEngine {
+  TunedCrackingEngine(int *a, int n, int extra): crackstore::CrackingEngine(a, n, extra) { enable_tuning(); }
+};
+TunedCrackingEngine *new_engine(TunedCrackingEngine*, int *a, int n, int cap){
+  return new TunedCrackingEngine(a, n, cap - n);
+}
+crackstore::AdaptiveMergingEngine *new_engine(crackstore::AdaptiveMergingEngine*, int *a, int n, int){
+  return new crackstore::AdaptiveMergingEngine(a, n);
+}
+
+template <class E>
+class Engine : public Algorithm { public:
+  E *engine;
+
+  Engine(): engine(0) {}
+  ~Engine(){ delete engine; }
+
+  void init(int *a, int n, int cap){
+    engine = new_engine((E*) 0, a, n, cap);
+  }
+
+  void insert(int v){ engine->insert(v); }
+
+  void remove(int v){ engine->remove(v); }
+
+  // the view's runs point into the engine: the cracked column, or the
+  // adaptive merging engine's final partitions
+  int view_query(int a, int b){
+    std::vector<crackstore::ValueRun> runs = engine->range_view(a, b);
+    count_stats();
+    int res = 0;
+    REP(i,runs.size()) res += runs[i].size;
+    return res;
+  }
+
+  int count_query(int a, int b){
+    int res = engine->range_query(a, b);
+    count_stats();
+    return res;
+  }
+
+  void count_stats(){
+    crackstore::CrackingStats st = engine->get_stats();
+    n_touched += st.last_tuples_touched;
+    n_cracks += st.last_cracks_created;
+  }
+};
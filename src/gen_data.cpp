@@ -1,24 +1,196 @@
+// Synthetic datasets for the experiments.
+//
+// usage: gen_data N [distribution [param]] [-s seed] [-t threads] [-o file] [--64] [--header]
+//
+//   uniform          abs(nextInt()), the original N.data (default)
+//   sorted           ascending, evenly spread over the domain
+//   reverse          descending
+//   nearly [p]       sorted, with p% (default 1) of each chunk's values swapped
+//                    in random pairs
+//   zipf [s]         Zipf ranks with exponent s (default 1.0) over N ranks, the
+//                    rank scattered over the domain, so the hot values are
+//                    anywhere in the value range
+//   clustered [r]    runs of r (default 1000) consecutive values, each run
+//                    from its own random 1/1000 of the domain
+//   dups [d]         only d (default 1000) distinct values, evenly spaced
+//
+// --64 writes 64-bit values over [0, 2^63) instead of 32-bit ones over
+// [0, 2^31). --header prefixes the DataHeader of data_file.h (distribution,
+// parameter, seed, value size), which the harness recognizes.
+//
+// The output is N.data for the default, else N_<distribution>[_64].data
+// (.hdata with --header). Values are generated in fixed chunks of CHUNK on
+// all cores; each chunk has its own seed derived from the seed and the chunk
+// number, so the file only depends on the arguments, not the thread count.
+// uniform instead skips ahead in the one sequence, which keeps N.data
+// identical to what the single-threaded generator always wrote.
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
+#include <stdint.h>
 #include <algorithm>
+#include <limits>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
 #include "random.h"
+#include "data_file.h"
 
 using namespace std;
 
-int main(int argc, char *argv[]){
-  int N;
-  Random r(140384);
-  sscanf(argv[1],"%d",&N);
-  int *arr = new int[N];
-  for (int i=0; i<N; i++) arr[i] = abs(r.nextInt());
-  // for (int i=0; i<N; i++) arr[i] = i;
-  // for (int i=0; i<N; i++)
-  //   swap(arr[i],arr[r.nextInt(N)]);
-  
-  char fn[100];
-  sprintf(fn,"%d.data",N);
+const long long CHUNK = 1 << 20;
+
+const char *dist = "uniform";
+double param = 0;
+long long N, seed = 140384;
+
+// splitmix64: decorrelated seeds for chunk (or run) number k
+long long chunk_seed(long long k){
+  unsigned long long z = (unsigned long long) seed + (k + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return (long long) (z ^ (z >> 31));
+}
+
+// uniform in [0, n) for n up to 2^63
+long long uniform(Random &r, long long n){
+  return (long long) (((unsigned long long) r.nextLong() >> 1) % (unsigned long long) n);
+}
+
+// Zipf ranks 1..n with P(k) ~ k^-s, by rejection-inversion sampling
+// (Hormann & Derflinger), constant expected time for any n and s > 0
+struct Zipf {
+  long long n;
+  double s, hx1, hn, sv;
+
+  static double helper1(double x){ return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1 / 3.0 - 0.25 * x)); }
+  static double helper2(double x){ return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x)); }
+  double h(double x){ return exp(-s * log(x)); }
+  double H(double x){ double lx = log(x); return helper2((1 - s) * lx) * lx; }
+  double Hinv(double x){ double t = max(-1.0, x * (1 - s)); return exp(helper1(t) * x); }
+
+  Zipf(long long n, double s): n(n), s(s) {
+    hx1 = H(1.5) - 1;
+    hn = H(n + 0.5);
+    sv = 2 - Hinv(H(2.5) - h(2));
+  }
+
+  long long next(Random &r){
+    while (true){
+      double u = hn + r.nextDouble() * (hx1 - hn);
+      double x = Hinv(u);
+      long long k = (long long) (x + 0.5);
+      if (k < 1) k = 1; else if (k > n) k = n;
+      if (k - x <= sv || u >= H(k + 0.5) - h(k)) return k;
+    }
+  }
+};
+
+// values [from, to) of the dataset, from a multiple of CHUNK
+template <class T>
+void generate(T *out, long long from, long long to){
+  const long long MAXV = numeric_limits<T>::max();
+  Random r(chunk_seed(from / CHUNK));
+  long long gap = max(1LL, MAXV / N);     // sorted: value i is in [i*gap, (i+1)*gap)
+
+  if (!strcmp(dist,"uniform")){
+    Random u(seed);
+    u.skip((unsigned long long) from * (sizeof(T) == 4 ? 1 : 2));
+    for (long long i=from; i<to; i++)
+      out[i] = sizeof(T) == 4 ? (T) abs(u.nextInt()) : (T) (u.nextLong() & MAXV);
+  } else if (!strcmp(dist,"sorted") || !strcmp(dist,"nearly")){
+    for (long long i=from; i<to; i++) out[i] = (T) (i * gap + uniform(r, gap));
+    if (!strcmp(dist,"nearly")){
+      long long swaps = (long long) ((to - from) * (param ? param : 1) / 200);
+      for (long long j=0; j<swaps; j++)
+        swap(out[from + uniform(r, to - from)], out[from + uniform(r, to - from)]);
+    }
+  } else if (!strcmp(dist,"reverse")){
+    for (long long i=from; i<to; i++) out[i] = (T) ((N - 1 - i) * gap + uniform(r, gap));
+  } else if (!strcmp(dist,"zipf")){
+    Zipf z(N, param ? param : 1.0);
+    for (long long i=from; i<to; i++)     // an odd multiplier permutes [0, 2^bits)
+      out[i] = (T) ((unsigned long long) z.next(r) * 0x9E3779B97F4A7C15ULL & MAXV);
+  } else if (!strcmp(dist,"clustered")){
+    long long run = param ? (long long) param : 1000, width = MAXV / 1000;
+    for (long long i=from; i<to; ){
+      Random c(chunk_seed(-1 - i / run));  // the run's range, wherever the chunk boundary is
+      long long lo = uniform(c, MAXV - width), end = min(to, (i / run + 1) * run);
+      for (; i<end; i++) out[i] = (T) (lo + uniform(r, width));
+    }
+  } else if (!strcmp(dist,"dups")){
+    long long d = param ? (long long) param : 1000, step = max(1LL, MAXV / d);
+    for (long long i=from; i<to; i++) out[i] = (T) (uniform(r, d) * step);
+  } else {
+    assert(0);
+  }
+}
+
+template <class T>
+void run(const char *fn, int threads, bool header){
+  T *arr = new T[N];
+  atomic<long long> next(0);
+  vector<thread> workers;
+  for (int t=0; t<threads; t++) workers.emplace_back([&](){
+    for (long long c; (c = next.fetch_add(1)) * CHUNK < N; )
+      generate<T>(arr, c * CHUNK, min(N, (c + 1) * CHUNK));
+  });
+  for (size_t t=0; t<workers.size(); t++) workers[t].join();
+
   FILE *out = fopen(fn,"wb");
-  int nw = fwrite(arr, sizeof(int), N, out);
+  if (!out){ fprintf(stderr,"Cannot write %s\n",fn); exit(1); }
+  if (header){
+    DataHeader h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, "SCRKDAT1", 8);
+    h.value_bytes = sizeof(T);
+    h.header_bytes = sizeof h;
+    h.n = N;
+    h.seed = seed;
+    strncpy(h.distribution, dist, sizeof h.distribution - 1);
+    h.param = param;
+    int nw = fwrite(&h, sizeof h, 1, out);
+    assert(nw == 1);
+  }
+  long long nw = fwrite(arr, sizeof(T), N, out);
   assert(nw == N);
   fclose(out);
+  delete[] arr;
+}
+
+int main(int argc, char *argv[]){
+  const char *dists[] = { "uniform", "sorted", "reverse", "nearly", "zipf", "clustered", "dups" };
+  const char *fn = NULL;
+  int threads = max(1u, thread::hardware_concurrency()), wide = 0, header = 0, npos = 0;
+  for (int i=1; i<argc; i++){
+    if (!strcmp(argv[i],"-s") && i+1 < argc) seed = atoll(argv[++i]);
+    else if (!strcmp(argv[i],"-t") && i+1 < argc) threads = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i],"-o") && i+1 < argc) fn = argv[++i];
+    else if (!strcmp(argv[i],"--64")) wide = 1;
+    else if (!strcmp(argv[i],"--header")) header = 1;
+    else if (npos == 0) N = atoll(argv[i]), npos++;
+    else if (npos == 1) dist = argv[i], npos++;
+    else if (npos == 2) param = atof(argv[i]), npos++;
+    else npos = -1;
+  }
+  bool known = false;
+  for (int i=0; i<7; i++) known |= !strcmp(dist, dists[i]);
+  if (N <= 0 || npos < 0 || !known){
+    fprintf(stderr,"usage: %s N [uniform|sorted|reverse|nearly [p]|zipf [s]|clustered [r]|dups [d]]"
+        " [-s seed] [-t threads] [-o file] [--64] [--header]\n", argv[0]);
+    exit(1);
+  }
+
+  string name = to_string(N);
+  if (strcmp(dist,"uniform")) name += string("_") + dist;
+  if (wide) name += "_64";
+  name += header ? ".hdata" : ".data";
+  if (!fn) fn = name.c_str();
+
+  if (wide) run<long long>(fn, threads, header);
+  else run<int>(fn, threads, header);
 }
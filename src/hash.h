@@ -1,8 +1,14 @@
 #ifndef _FH_HASH_
 #define _FH_HASH_
 
+#include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 class Hash {
   int *key,*val,N,S;
@@ -78,4 +84,105 @@ public :
   }
 };
 
+// A multiset of keys (key -> count) for the hash joins of merge-ripple
+// deletes, built to be reset and refilled on every call rather than
+// allocated. Open addressing over groups of 16 slots, probed linearly: a
+// control byte per slot holds EMPTY or 7 bits of the key's hash, so one
+// group is matched with a single SSE2 compare and keys are only read on a
+// tag match. Any key value can be stored (no sentinel keys), and keys are
+// never removed, only their counts decremented, so there are no tombstones.
+//
+// The control bytes, keys and counts live in one arena that only grows;
+// reset(n) sizes the table for n keys and clears only that many control
+// bytes, so small calls after a large one stay cheap.
+template <class K = int>
+class HashMultiset {
+  enum { GROUP = 16 };
+  static const uint8_t EMPTY = 0x80;
+
+  char *arena;
+  size_t arena_bytes;
+  uint8_t *ctrl;
+  K *keys;
+  int *counts;
+  size_t mask;    // groups - 1
+  int shift;      // 64 - log2(slots)
+
+  uint64_t hash(K k) const { return (uint64_t) k * 0x9E3779B97F4A7C15ULL; }
+
+  // bit i set where group g's control byte i is b
+  unsigned match(size_t g, uint8_t b) const {
+    const uint8_t *c = ctrl + g * GROUP;
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*) c), _mm_set1_epi8((char) b)));
+#else
+    unsigned m = 0;
+    for (int i=0; i<GROUP; i++) m |= (unsigned) (c[i] == b) << i;
+    return m;
+#endif
+  }
+
+  // the slot of k, or -1 with empty set to where it would go
+  long find(K k, long &empty) const {
+    uint64_t h = hash(k);
+    uint8_t tag = (uint8_t) (h & 0x7f);
+    for (size_t g = (h >> shift) / GROUP; ; g = (g + 1) & mask){
+      for (unsigned m = match(g, tag); m; m &= m - 1){
+        long s = g * GROUP + __builtin_ctz(m);
+        if (keys[s] == k) return s;
+      }
+      unsigned e = match(g, EMPTY);
+      if (e){ empty = g * GROUP + __builtin_ctz(e); return -1; }
+    }
+  }
+
+public:
+  HashMultiset(): arena(0), arena_bytes(0), ctrl(0), keys(0), counts(0), mask(0), shift(0) { reset(0); }
+  ~HashMultiset(){ free(arena); }
+
+  // empties the table, with room for n keys at a load of at most 1/2
+  void reset(size_t n){
+    size_t slots = GROUP;
+    while (slots < 2 * n) slots <<= 1;
+    size_t bytes = slots * (1 + sizeof(K) + sizeof(int));
+    if (bytes > arena_bytes){
+      free(arena);
+      arena_bytes = bytes > 2 * arena_bytes ? bytes : 2 * arena_bytes;
+      if (posix_memalign((void**) &arena, 64, arena_bytes)) arena = 0;
+      assert(arena);
+    }
+    ctrl = (uint8_t*) arena;
+    keys = (K*) (arena + slots);
+    counts = (int*) (arena + slots * (1 + sizeof(K)));
+    mask = slots / GROUP - 1;
+    shift = 64 - __builtin_ctzll(slots);
+    memset(ctrl, EMPTY, slots);
+  }
+
+  // one more k
+  void add(K k){
+    long e = -1, s = find(k, e);
+    if (s < 0){
+      s = e;
+      ctrl[s] = (uint8_t) (hash(k) & 0x7f);
+      keys[s] = k;
+      counts[s] = 0;
+    }
+    counts[s]++;
+  }
+
+  // removes one k if there is any, and says whether there was
+  bool take(K k){
+    long e = -1, s = find(k, e);
+    if (s < 0 || counts[s] == 0) return false;
+    counts[s]--;
+    return true;
+  }
+
+  int count(K k) const {
+    long e = -1, s = find(k, e);
+    return s < 0 ? 0 : counts[s];
+  }
+};
+
 #endif
@@ -1,57 +1,110 @@
+// Checks HashMultiset against std::multiset, then measures the hash join of
+// merge-ripple deletes (crackers.h) with it and with the Hash it replaced:
+// per call, a table for n pending deletes is built and the piece, 4n tuples
+// of which n are deleted, is probed. Hash is allocated and cleared per call
+// as do_merge_ripple_delete did; HashMultiset is reset.
+//
+// usage: hash_tester [seconds per measurement]
+
 #include "hash.h"
+#include "random.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
-#include <map>
+#include <chrono>
+#include <set>
+#include <vector>
+#include <algorithm>
 
 using namespace std;
 
-int main(){
-  map<int,int> m;
-  Hash h(1000000);
-  int a=0,b=0,c=0;
-
-  for (int i=0; i<1000000; i++)
-    h.set(i,i);
-
-  fprintf(stderr,"%d\n",1);
+#define REP(i,n) for (int i=0,_n=n; i<_n; i++)
 
-  for (int i=0; i<100000; i++){
-    int k = rand() % 1000000 + 1;
-    int v = rand() % 1000000 + 1;
-    if (m.count(k)) continue;
-    m[k] = v;
-    h.set(k,v);
-    a++;
-  }
+double min_time = 0.2;
+long long sink;
 
-  fprintf(stderr,"inserted\n");
-
-  for (int i=0; i<2000000; i++){
-    if (i%100000==0) fprintf(stderr,".");
-    int k = rand() % 1000000 + 1;
-    int v = rand() % 1000000 + 1;
-    if (rand()%2){
-      // add
-      if (m.count(k)) continue;
-      m[k] = v;
-      h.set(k,v);
-      b++;
-    } else {
-      // remove
-      if (!m.count(k)) continue;
-      m.erase(k);
-      h.erase(k);
-      c++;
+void check(){
+  Random r(2014);
+  HashMultiset<int> h;
+  multiset<int> m;
+  REP(round,200){
+    int n = r.nextInt(5000), range = r.nextInt(2) ? 100 : 2000000000;
+    h.reset(n);
+    m.clear();
+    REP(i,n){
+      int k = r.nextInt(range) - range / 2;   // negative keys too
+      h.add(k);
+      m.insert(k);
+    }
+    REP(i,3*n){
+      int k = r.nextInt(range) - range / 2;
+      multiset<int>::iterator it = m.find(k);
+      assert(h.count(k) == (int) m.count(k));
+      assert(h.take(k) == (it != m.end()));
+      if (it != m.end()) m.erase(it);
     }
   }
+  fprintf(stderr,"HashMultiset matches std::multiset\n");
+}
 
-  fprintf(stderr,"\nchecking %d %d %d\n",a,b,c);
+// ns per operation (build + probe) of f, repeated for at least min_time
+template <class F>
+double measure(F f, long long ops){
+  typedef chrono::steady_clock Clock;
+  long long reps = 0;
+  Clock::time_point t0 = Clock::now();
+  double elapsed;
+  do {
+    f();
+    reps++;
+    elapsed = chrono::duration<double>(Clock::now() - t0).count();
+  } while (elapsed < min_time);
+  return elapsed * 1e9 / (reps * ops);
+}
+
+int main(int argc, char *argv[]){
+  if (argc > 1) min_time = atof(argv[1]);
+  check();
+
+  printf("%10s %10s %10s %14s %8s\n", "deletes", "calls", "Hash_ns", "Multiset_ns", "speedup");
+  const int sizes[] = { 4, 16, 128, 1024, 16384, 262144, 1048576 };
+  REP(si,7){
+    int n = sizes[si], calls = max(1, (1 << 20) / (5 * n));
+    Random r(160284 + si);
+    vector<int> del(n), piece(4 * n);
+    REP(i,n) del[i] = abs(r.nextInt());
+    REP(i,4*n) piece[i] = i < n ? del[i] : abs(r.nextInt());
+    REP(i,4*n) swap(piece[i], piece[i + r.nextInt(4 * n - i)]);
+    long long ops = (long long) calls * 5 * n;
 
-  map<int,int>::iterator it = m.begin();
-  while (it != m.end()){
-    int k = it->first, v = it->second;
-    assert(h.get(k) == v);
-    it++;
+    double old_ns = measure([&]{
+      REP(c,calls){
+        Hash h(n);
+        REP(i,n){
+          int v = h.get(del[i]);
+          h.set(del[i], (v>0)? (v+1) : 1);
+        }
+        long long hit = 0;
+        REP(i,4*n){
+          int v = h.get(piece[i]);
+          if (v > 0){ h.set(piece[i], v-1); hit++; }
+        }
+        sink += hit;
+      }
+    }, ops);
+
+    HashMultiset<int> h;
+    double new_ns = measure([&]{
+      REP(c,calls){
+        h.reset(n);
+        REP(i,n) h.add(del[i]);
+        long long hit = 0;
+        REP(i,4*n) hit += h.take(piece[i]);
+        sink += hit;
+      }
+    }, ops);
+
+    printf("%10d %10d %10.2lf %14.2lf %7.2lfx\n", n, calls, old_ns, new_ns, old_ns / new_ns);
   }
+  return 0;
 }
-
@@ -0,0 +1,145 @@
+#ifndef _SCRACK_METRICS_H_
+#define _SCRACK_METRICS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <zlib.h>
+#include <string>
+#include <vector>
+
+// Per-query metrics (res/*.mtr), recorded into preallocated in-memory
+// columns and written once after the run, so the measurement loop does no
+// formatting or I/O. Shared by tester.h and the distributed client's
+// workload replay; res_parser reads the files.
+//
+// File layout, zlib (gzip) compressed, little-endian:
+//   "SCRKMTR1"                          8-byte magic
+//   int32 ncols, int32 nrows
+//   ncols x { char name[24]; int32 type }   type 0 = int32, 1 = float64
+//   ncols x nrows values, column by column
+
+class MetricsRecorder { public:
+	struct Column {
+		char name[24];
+		int type;
+		std::vector<int> i;
+		std::vector<double> d;
+	};
+
+	// columns hold `capacity` rows, allocated up front
+	MetricsRecorder(const char *const fn, int capacity): fn(fn), rows(0), cap(capacity > 0 ? capacity : 1) {}
+	~MetricsRecorder(){ flush(); }
+
+	// registers a column before the first row and returns its storage:
+	// the caller writes row r as column[r]
+	int *ints(const char *name){ return &add(name, 0).i[0]; }
+	double *doubles(const char *name){ return &add(name, 1).d[0]; }
+
+	int size() const { return rows; }
+
+	// marks row size() complete
+	void next(){ assert(rows < cap); rows++; }
+
+	// writes the file (once); exits on I/O errors
+	void flush(){
+		if (fn.empty()) return;
+		gzFile f = gzopen(fn.c_str(), "wb1");	// fast level: the data is highly regular anyway
+		if (!f){ fprintf(stderr, "gzopen of '%s' failed.\n", fn.c_str()); exit(EXIT_FAILURE); }
+		int32_t hdr[2] = { (int32_t) cols.size(), rows };
+		put(f, "SCRKMTR1", 8);
+		put(f, hdr, sizeof hdr);
+		for (size_t c=0; c<cols.size(); c++){
+			put(f, cols[c].name, sizeof cols[c].name);
+			int32_t type = cols[c].type;
+			put(f, &type, sizeof type);
+		}
+		for (size_t c=0; c<cols.size(); c++){
+			if (!rows) continue;
+			if (cols[c].type == 0) put(f, &cols[c].i[0], sizeof(int) * rows);
+			else put(f, &cols[c].d[0], sizeof(double) * rows);
+		}
+		gzclose(f);
+		fn.clear();
+	}
+
+private:
+	std::string fn;
+	int rows, cap;
+	std::vector<Column> cols;
+
+	Column &add(const char *name, int type){
+		Column c;
+		memset(c.name, 0, sizeof c.name);
+		strncpy(c.name, name, sizeof c.name - 1);
+		c.type = type;
+		if (type == 0) c.i.resize(cap);
+		else c.d.resize(cap);
+		cols.push_back(c);
+		return cols.back();
+	}
+
+	static void put(gzFile f, const void *p, size_t n){
+		while (n > 0){
+			unsigned chunk = n > (1u << 30) ? (1u << 30) : (unsigned) n;
+			if (gzwrite(f, p, chunk) != (int) chunk){
+				int err_no = 0;
+				fprintf(stderr, "Error during compression: %s", gzerror(f, &err_no));
+				gzclose(f);
+				exit(err_no);
+			}
+			p = (const char*) p + chunk;
+			n -= chunk;
+		}
+	}
+};
+
+// Reads one column of a metrics file as doubles, and its type (0 = int32,
+// 1 = float64) if `type` is given. Returns false (with a message) if the
+// file is not a metrics file or has no such column; with names != NULL,
+// the file's column names are stored there as well.
+inline bool read_metrics_column(const char *fn, const char *name, std::vector<double> &out,
+		int *type = NULL, std::vector<std::string> *names = NULL){
+	gzFile f = gzopen(fn, "rb");
+	if (!f){ fprintf(stderr, "Cannot open %s\n", fn); return false; }
+	char magic[8];
+	int32_t hdr[2];
+	if (gzread(f, magic, 8) != 8 || memcmp(magic, "SCRKMTR1", 8) || gzread(f, hdr, sizeof hdr) != sizeof hdr){
+		fprintf(stderr, "%s is not a metrics file\n", fn);
+		gzclose(f);
+		return false;
+	}
+	int ncols = hdr[0], nrows = hdr[1], found = -1;
+	std::vector<int32_t> types(ncols);
+	long long skip = 0;
+	for (int c=0; c<ncols; c++){
+		char cname[24];
+		gzread(f, cname, sizeof cname);
+		gzread(f, &types[c], sizeof(int32_t));
+		cname[sizeof cname - 1] = 0;
+		if (names) names->push_back(cname);
+		if (found < 0 && !strcmp(cname, name)) found = c;
+		else if (found < 0) skip += (long long) nrows * (types[c] ? sizeof(double) : sizeof(int));
+	}
+	if (found < 0){
+		if (name[0]) fprintf(stderr, "%s has no column '%s'\n", fn, name);
+		gzclose(f);
+		return false;
+	}
+	gzseek(f, skip, SEEK_CUR);
+	if (type) *type = types[found];
+	out.resize(nrows);
+	if (types[found] == 0){
+		std::vector<int> v(nrows);
+		if (nrows) gzread(f, &v[0], sizeof(int) * nrows);
+		for (int r=0; r<nrows; r++) out[r] = v[r];
+	} else if (nrows){
+		gzread(f, &out[0], sizeof(double) * nrows);
+	}
+	gzclose(f);
+	return true;
+}
+
+#endif
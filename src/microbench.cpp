@@ -0,0 +1,398 @@
+// Microbenchmarks for the cracking kernels in crackers.h and the Hash index.
+//
+// usage: microbench [quick|full] [filter]
+//
+// Sweeps piece sizes, selectivities and data distributions for the
+// partitioning kernels, and index sizes for the cracker index and Hash.
+// Results go to stdout as one JSON document (progress to stderr), so runs
+// can be diffed and tracked for regressions:
+//
+//   ./bin/microbench full > bench.json
+//   ./bin/microbench quick split_ab       # only cases whose name contains "split_ab"
+//
+// Each case is warmed up once, then repeated until it has at least MIN_REPS
+// samples and MIN_TIME of measured work; the median is reported along with
+// the min and the relative standard deviation. Kernels that rearrange data
+// work on a fresh copy every repetition (the copy is not timed), and small
+// pieces are batched so every repetition touches the same number of
+// elements (small hash tables likewise). The process pins itself to the CPU it starts on.
+//
+// With SCRACK_PERF=1 the measured repetitions also run under the hardware
+// counters of perf_counters.h, and each result gets their totals per unit
+// (hw_instructions_per_unit, ...) for the counters the machine exposes;
+// hw_cycles are core clock cycles, cycles_per_unit stays the TSC.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <assert.h>
+#include <string>
+#include <algorithm>
+#include <functional>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// statistics crackers.h updates; normally defined by tester.h
+int n_touched, n_trash, n_rippled;
+struct NoTimer { void start(){} void stop(){} } mri_t, mrd_t;
+
+#include "crackers.h"       // partition, split_ab, symmetric_crack3, split_abc, find_piece, add_crack, Hash
+#include "random.h"
+#include "perf_counters.h"
+
+double MIN_TIME = 0.2e9;          // ns of measured work per case (quick: 0.05e9)
+const int MIN_REPS = 5, MAX_REPS = 1000;
+
+volatile long long sink;          // keeps results alive
+bool quick = false;
+const char *filter = "";
+int nresults = 0;
+PerfCounters pc;                  // opened with SCRACK_PERF=1
+
+static inline double now_ns(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// reference cycles (TSC); 0 where there is no cycle counter
+static inline unsigned long long cycles(){
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+struct Stats {
+  double ns, ns_min, cyc, rsd;
+  double counter[PerfCounters::NCOUNTERS];    // per element, over all measured reps
+  int reps;
+};
+
+// times run() after each untimed setup(), per element
+template <class Setup, class Run>
+Stats measure(Setup setup, Run run, double elements){
+  vector<double> ns, cyc;
+  double spent = 0;
+  pc.clear();
+  for (int rep=-1; rep<MAX_REPS; rep++){   // rep -1 is the warm-up
+    setup();
+    if (rep >= 0) pc.start();             // reads the counters outside the timed region
+    double t0 = now_ns();
+    unsigned long long c0 = cycles();
+    run();
+    unsigned long long c1 = cycles();
+    double t1 = now_ns();
+    if (rep < 0) continue;
+    pc.stop();
+    ns.push_back((t1 - t0) / elements);
+    cyc.push_back((c1 - c0) / elements);
+    spent += t1 - t0;
+    if ((int)ns.size() >= MIN_REPS && spent >= MIN_TIME) break;
+  }
+
+  Stats s;
+  s.reps = ns.size();
+  double mean = 0, var = 0;
+  REP(i,s.reps) mean += ns[i];
+  mean /= s.reps;
+  REP(i,s.reps) var += (ns[i] - mean) * (ns[i] - mean);
+  s.rsd = mean > 0 ? sqrt(var / s.reps) / mean : 0;
+  sort(ns.begin(), ns.end());
+  sort(cyc.begin(), cyc.end());
+  s.ns = ns[s.reps / 2];
+  s.ns_min = ns[0];
+  s.cyc = cyc[s.reps / 2];
+  REP(c,PerfCounters::NCOUNTERS) s.counter[c] = pc.value(c) / (elements * s.reps);
+  return s;
+}
+
+bool selected(const string &name){
+  return name.find(filter) != string::npos;
+}
+
+void report(const string &name, const char *kernel, const char *dist, long long n,
+    double sel, long long index_size, const char *unit, const Stats &s){
+  printf("%s\n    {\"name\": \"%s\", \"kernel\": \"%s\", \"distribution\": \"%s\", "
+      "\"n\": %lld, \"selectivity\": %g, \"index_size\": %lld, \"unit\": \"%s\", "
+      "\"ns_per_unit\": %.4lf, \"ns_per_unit_min\": %.4lf, \"cycles_per_unit\": %.4lf, "
+      "\"rsd\": %.4lf, \"reps\": %d",
+      nresults++ ? "," : "", name.c_str(), kernel, dist, n, sel, index_size, unit,
+      s.ns, s.ns_min, s.cyc, s.rsd, s.reps);
+  REP(c,PerfCounters::NCOUNTERS) if (pc.available(c))
+    printf(", \"hw_%s_per_unit\": %.4lf", PerfCounters::name(c), s.counter[c]);
+  printf("}");
+  fflush(stdout);
+  fprintf(stderr, "%-40s %9.3lf ns/%s %9.2lf cyc/%s  (rsd %.3lf, %d reps)\n",
+      name.c_str(), s.ns, unit, s.cyc, unit, s.rsd, s.reps);
+}
+
+
+// ---- data distributions ----------------------------------------------------
+
+const char *DISTS[] = { "uniform", "sorted", "reverse", "skewed", "dups" };
+const int NDISTS = 5;
+
+// fills `pieces` pieces of n values each; sorted/reverse order every piece
+// on its own so all pieces see the same value distribution
+void generate(vector<int> &v, int n, int pieces, const char *dist, Random &r){
+  v.resize((size_t)n * pieces);
+  REP(i,(int)v.size()){
+    if (!strcmp(dist,"skewed")) v[i] = (int)(2147483647.0 * pow(r.nextDouble(), 4));  // most values small
+    else if (!strcmp(dist,"dups")) v[i] = r.nextInt(100);                             // 100 distinct values
+    else v[i] = abs(r.nextInt());                                                     // as gen_data
+  }
+  if (!strcmp(dist,"sorted") || !strcmp(dist,"reverse")){
+    REP(p,pieces){
+      int *b = &v[(size_t)p * n];
+      sort(b, b + n);
+      if (!strcmp(dist,"reverse")) reverse(b, b + n);
+    }
+  }
+}
+
+// value below which a fraction q of the data falls, from a sorted sample
+int quantile(const vector<int> &sample, double q){
+  int i = (int)(q * sample.size());
+  return sample[max(0, min(i, (int)sample.size() - 1))];
+}
+
+
+// ---- partitioning kernels --------------------------------------------------
+
+void bench_pieces(){
+  const int sizes_full[] = { 1 << 10, 1 << 14, 1 << 18, 1 << 22 };
+  const int sizes_quick[] = { 1 << 10, 1 << 16, 1 << 20 };
+  const double sels[] = { 0.01, 0.1, 0.5 };
+  const char *kernels[] = { "partition", "split_ab", "symmetric_crack3", "split_abc" };
+  const int *sizes = quick ? sizes_quick : sizes_full;
+  int nsizes = quick ? 3 : 4;
+  int work = quick ? 1 << 20 : 1 << 22;   // elements touched per repetition
+
+  REP(d,NDISTS) REP(si,nsizes){
+    int n = sizes[si], pieces = max(1, work / n);
+    char name[200];
+
+    // skip generating data nobody asked for
+    bool any = false;
+    REP(k,4) REP(s,3){
+      snprintf(name, sizeof name, "%s/%s/%d/%g", kernels[k], DISTS[d], n, sels[s]);
+      any |= selected(name);
+    }
+    if (!any) continue;
+
+    Random r(140384 + d * 31 + si);
+    vector<int> pristine, data, sample;
+    generate(pristine, n, pieces, DISTS[d], r);
+    data.resize(pristine.size());
+    REP(i,65536) sample.push_back(pristine[r.nextInt(pristine.size())]);
+    sort(sample.begin(), sample.end());
+
+    REP(k,4) REP(s,3){
+      snprintf(name, sizeof name, "%s/%s/%d/%g", kernels[k], DISTS[d], n, sels[s]);
+      if (!selected(name)) continue;
+      double sel = sels[s];
+      int a = quantile(sample, (1 - sel) / 2), mid = quantile(sample, 0.5),
+          b = quantile(sample, (1 + sel) / 2), pivot = quantile(sample, sel);
+      int *arr = &data[0];
+
+      Stats st = measure(
+        [&]{ memcpy(arr, &pristine[0], sizeof(int) * pristine.size()); },
+        [&]{
+          long long acc = 0;
+          REP(p,pieces){
+            int L = p * n, R = L + n, i1, i2, i3;
+            switch (k){
+              case 0: acc += partition(arr, pivot, L, R); break;
+              case 1: split_ab(arr, L, R, a, b, i1, i2); acc += i1 + i2; break;
+              case 2: symmetric_crack3(arr, L, R, a, b, i1, i2); acc += i1 + i2; break;
+              case 3: split_abc(arr, L, R, a, mid, b, i1, i2, i3); acc += i1 + i2 + i3; break;
+            }
+          }
+          sink += acc;
+        },
+        (double)n * pieces);
+      report(name, kernels[k], DISTS[d], n, sel, 0, "element", st);
+    }
+  }
+}
+
+
+// ---- cracker index ---------------------------------------------------------
+
+// K cracks at values i*G with position = value, so new cracks at values that
+// are not multiples of G fall strictly between existing ones
+const int G = 1024;
+
+void build_index(ci_type &ci, int K){
+  ci.clear();
+  for (int i=1; i<=K; i++) ci[i * G] = (CIndex){ i * G, 0, false };
+}
+
+// lookup keys over the index's value range
+void index_keys(vector<int> &keys, int K, int count, const char *dist, Random &r){
+  keys.resize(count);
+  long long range = (long long)(K + 1) * G;
+  REP(i,count){
+    double u = r.nextDouble();
+    if (!strcmp(dist,"skewed")) u = pow(u, 4);   // hot low end of the index
+    keys[i] = (int)(u * range);
+  }
+}
+
+void bench_index(){
+  const int sizes_full[] = { 16, 1 << 10, 1 << 16, 1 << 20 };
+  const int sizes_quick[] = { 16, 1 << 10, 1 << 16 };
+  const char *dists[] = { "uniform", "skewed" };
+  const int *sizes = quick ? sizes_quick : sizes_full;
+  int nsizes = quick ? 3 : 4;
+  const int LOOKUPS = 1 << 20, ADDS = 1 << 14;
+  char name[200];
+
+  REP(si,nsizes) REP(d,2){
+    int K = sizes[si], N = (K + 1) * G;
+    Random r(280484 + si * 7 + d);
+    ci_type ci, work;
+    build_index(ci, K);
+
+    snprintf(name, sizeof name, "find_piece/%s/%d", dists[d], K);
+    if (selected(name)){
+      vector<int> keys;
+      index_keys(keys, K, LOOKUPS, dists[d], r);
+      Stats st = measure([]{}, [&]{
+          long long acc = 0;
+          REP(i,LOOKUPS){
+            int L, R;
+            find_piece(ci, N, keys[i], L, R);
+            acc += L + R;
+          }
+          sink += acc;
+        }, LOOKUPS);
+      report(name, "find_piece", dists[d], N, 0, K, "op", st);
+    }
+
+    snprintf(name, sizeof name, "add_crack/%s/%d", dists[d], K);
+    if (selected(name)){
+      vector<int> keys;
+      index_keys(keys, K, ADDS, dists[d], r);
+      REP(i,ADDS) if (keys[i] % G == 0) keys[i]++;   // new values only
+      Stats st = measure([&]{ work = ci; }, [&]{
+          long long acc = 0;
+          REP(i,ADDS) acc += add_crack(work, N, keys[i], keys[i]);
+          sink += acc;
+        }, ADDS);
+      report(name, "add_crack", dists[d], N, 0, K, "op", st);
+    }
+  }
+}
+
+
+// ---- Hash ------------------------------------------------------------------
+
+void bench_hash(){
+  const int sizes_full[] = { 1 << 10, 1 << 16, 1 << 20, 1 << 22 };
+  const int sizes_quick[] = { 1 << 10, 1 << 16 };
+  const char *ops[] = { "set", "get_hit", "get_miss", "erase" };
+  const int *sizes = quick ? sizes_quick : sizes_full;
+  int nsizes = quick ? 2 : 4;
+  char name[200];
+
+  REP(si,nsizes){
+    int K = sizes[si];
+    bool any = false;
+    REP(o,4){
+      snprintf(name, sizeof name, "hash_%s/uniform/%d", ops[o], K);
+      any |= selected(name);
+    }
+    if (!any) continue;
+
+    // distinct non-negative keys (negative keys mark empty slots); misses
+    // are drawn from a disjoint set
+    Random r(50584 + si);
+    vector<int> keys(K), misses(K);
+    REP(i,K){
+      keys[i] = 2 * i;
+      misses[i] = 2 * r.nextInt(1 << 29) + 1;
+    }
+    REP(i,K) swap(keys[i], keys[i + r.nextInt(K - i)]);
+
+    // small tables are batched like small pieces
+    int tables = max(1, (1 << 16) / K);
+    vector<Hash*> hs(tables);
+    REP(t,tables) hs[t] = new Hash(K);
+
+    REP(o,4){
+      snprintf(name, sizeof name, "hash_%s/uniform/%d", ops[o], K);
+      if (!selected(name)) continue;
+      Stats st = measure(
+        [&]{
+          REP(t,tables){
+            hs[t]->clear();
+            if (o > 0) REP(i,K) hs[t]->set(keys[i], i);
+          }
+        },
+        [&]{
+          long long acc = 0;
+          REP(t,tables){
+            Hash &h = *hs[t];
+            switch (o){
+              case 0: REP(i,K) h.set(keys[i], i); break;
+              case 1: REP(i,K) acc += h.get(keys[i]); break;
+              case 2: REP(i,K) acc += h.get(misses[i]); break;
+              case 3: REP(i,K) h.erase(keys[i]); break;
+            }
+          }
+          sink += acc;
+        }, (double)K * tables);
+      report(name, ops[o], "uniform", K, 0, K, "op", st);
+    }
+    REP(t,tables) delete hs[t];
+  }
+}
+
+
+int main(int argc, char *argv[]){
+  if (argc > 1 && strcmp(argv[1],"quick") && strcmp(argv[1],"full")){
+    fprintf(stderr,"usage: %s [quick|full] [filter]\n", argv[0]);
+    exit(1);
+  }
+  quick = argc > 1 && !strcmp(argv[1],"quick");
+  if (argc > 2) filter = argv[2];
+  if (quick) MIN_TIME = 0.05e9;
+  const char *env = getenv("SCRACK_PERF");
+  if (env && atoi(env) && !pc.open())
+    fprintf(stderr, "hardware counters unavailable, not recorded\n");
+
+  int cpu = -1;
+#ifdef __linux__
+  cpu = sched_getcpu();
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof set, &set) != 0) cpu = -1;
+#endif
+
+  printf("{\n  \"harness\": {\"mode\": \"%s\", \"filter\": \"%s\", \"pinned_cpu\": %d, "
+      "\"min_reps\": %d, \"min_time_ms\": %.0lf, \"perf_counters\": %s, \"cycles\": \"%s\"},\n  \"results\": [",
+      quick ? "quick" : "full", filter, cpu, MIN_REPS, MIN_TIME / 1e6, pc.available() ? "true" : "false",
+#if defined(__x86_64__) || defined(__i386__)
+      "tsc"
+#else
+      "none"
+#endif
+      );
+
+  bench_pieces();
+  bench_index();
+  bench_hash();
+
+  printf("\n  ]\n}\n");
+}
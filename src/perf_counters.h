@@ -0,0 +1,115 @@
+#ifndef _SCRACK_PERF_COUNTERS_H_
+#define _SCRACK_PERF_COUNTERS_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// Hardware performance counters of the calling thread via perf_event_open:
+// cycles, instructions, LLC misses, branch misses and dTLB load misses,
+// opened as one group so they are scheduled (and multiplexed) together.
+// User space only, which works at the default perf_event_paranoid of 2.
+//
+// Events the CPU or hypervisor doesn't expose are left out individually;
+// if none can be opened, available() is false and every reading is zero,
+// so callers record counters unconditionally and only decide whether to
+// write them out.
+//
+//   PerfCounters pc;
+//   pc.open();
+//   pc.start(); work(); pc.stop();    // accumulates into pc.value(c)
+
+class PerfCounters { public:
+	enum { CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, NCOUNTERS };
+
+	static const char *name(int c){
+		static const char *names[NCOUNTERS] = { "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses" };
+		return names[c];
+	}
+
+	PerfCounters(): leader(-1), nopen(0) {
+		for (int c=0; c<NCOUNTERS; c++){ fd[c] = -1; slot[c] = -1; }
+		clear();
+	}
+	~PerfCounters(){ close_all(); }
+
+	// opens the group; returns false (without a message) if no counter is
+	// available
+	bool open(){
+#ifdef __linux__
+		const uint32_t types[NCOUNTERS] = {
+			PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE };
+		const uint64_t configs[NCOUNTERS] = {
+			PERF_COUNT_HW_CPU_CYCLES,
+			PERF_COUNT_HW_INSTRUCTIONS,
+			PERF_COUNT_HW_CACHE_MISSES,		// last level cache on every PMU we care about
+			PERF_COUNT_HW_BRANCH_MISSES,
+			PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) };
+
+		for (int c=0; c<NCOUNTERS; c++){
+			struct perf_event_attr pe;
+			memset(&pe, 0, sizeof pe);
+			pe.size = sizeof pe;
+			pe.type = types[c];
+			pe.config = configs[c];
+			pe.exclude_kernel = 1;
+			pe.exclude_hv = 1;
+			pe.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			pe.disabled = leader < 0;		// the group starts when the leader is enabled
+			fd[c] = syscall(__NR_perf_event_open, &pe, 0, -1, leader, 0);
+			if (fd[c] < 0) continue;		// not supported here: leave this one out
+			if (leader < 0) leader = fd[c];
+			slot[c] = nopen++;
+		}
+		if (leader < 0) return false;
+		ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool available() const { return leader >= 0; }
+	bool available(int c) const { return slot[c] >= 0; }
+
+	void clear(){ for (int c=0; c<NCOUNTERS; c++) acc[c] = 0; }
+
+	void start(){ snapshot(begin); }
+
+	// adds the counts since start(), scaled up if the group was multiplexed
+	void stop(){
+		long long end[NCOUNTERS];
+		snapshot(end);
+		for (int c=0; c<NCOUNTERS; c++) acc[c] += end[c] - begin[c];
+	}
+
+	long long value(int c) const { return acc[c]; }
+
+private:
+	int fd[NCOUNTERS], slot[NCOUNTERS], leader, nopen;
+	long long begin[NCOUNTERS], acc[NCOUNTERS];
+
+	void snapshot(long long *out){
+		for (int c=0; c<NCOUNTERS; c++) out[c] = 0;
+		if (leader < 0) return;
+		uint64_t buf[3 + NCOUNTERS];		// nr, time_enabled, time_running, values
+		if (read(leader, buf, sizeof buf) < (ssize_t) (3 * sizeof(uint64_t))) return;
+		double scale = buf[2] > 0 ? (double) buf[1] / buf[2] : 1.0;
+		for (int c=0; c<NCOUNTERS; c++)
+			if (slot[c] >= 0 && slot[c] < (int) buf[0]) out[c] = (long long) (buf[3 + slot[c]] * scale);
+	}
+
+	void close_all(){
+		for (int c=0; c<NCOUNTERS; c++) if (fd[c] >= 0) close(fd[c]);
+		leader = -1;
+	}
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef _SCRACK_QUERY_TRACE_H_
+#define _SCRACK_QUERY_TRACE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Query traces: the queries and updates an index received, in order, with
+// the time each was issued. SCRACK_RECORD=FILE records one (the tester, the
+// distributed client's replay); the query workload "trace:FILE" replays it
+// (workload.h), so a workload captured once, e.g. a concurrent run, can be
+// rerun deterministically against every algorithm and the cluster.
+//
+// The file is a QueryTraceHeader followed by fixed-size records, mapped
+// rather than read on replay. Times are microsecond deltas from the previous
+// record, taken from the rounded absolute times so they don't drift.
+
+enum { QT_VIEW, QT_COUNT, QT_INSERT, QT_DELETE };
+
+struct QueryTraceHeader {	// 64 bytes, little-endian
+	char magic[8];		// "SCRKQTR1"
+	int32_t record_bytes;	// sizeof(QueryTraceRecord)
+	int32_t header_bytes;	// sizeof(QueryTraceHeader); the records follow
+	int64_t n;		// records
+	int64_t rows;		// rows the index was initialized with
+	char updates[16];	// the recording's update workload; ROLL and APPEND
+				// prepare the data before init, replays do the same
+	char reserved[16];
+};
+
+struct QueryTraceRecord {	// 16 bytes
+	uint32_t dt_us;		// microseconds since the previous record
+	int32_t kind;		// QT_*
+	int32_t a, b;		// query [a, b); the inserted or deleted value is a
+};
+
+class QueryTraceWriter { public:
+	typedef std::chrono::steady_clock Clock;
+
+	// records are kept in memory and written by the destructor, so recording
+	// costs a clock read and an append per operation
+	QueryTraceWriter(const char *fn, const char *updates): fn(fn), rows(0), last_us(0) {
+		memset(upd, 0, sizeof upd);
+		strncpy(upd, updates, sizeof upd - 1);
+		restart(0);
+	}
+	~QueryTraceWriter(){ write(); }
+
+	// the index was just initialized with rows rows: times count from now
+	void restart(long long n){
+		rows = n;
+		t0 = Clock::now();
+		last_us = 0;
+		recs.clear();
+	}
+
+	void add(int kind, int a, int b = 0){
+		std::lock_guard<std::mutex> lock(mutex);
+		long long us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+		QueryTraceRecord r = { (uint32_t) (us - last_us), kind, a, b };
+		last_us = us;
+		recs.push_back(r);
+	}
+
+private:
+	const char *fn;
+	char upd[16];
+	long long rows, last_us;
+	Clock::time_point t0;
+	std::vector<QueryTraceRecord> recs;
+	std::mutex mutex;
+
+	void write(){
+		QueryTraceHeader h;
+		memset(&h, 0, sizeof h);
+		memcpy(h.magic, "SCRKQTR1", 8);
+		h.record_bytes = sizeof(QueryTraceRecord);
+		h.header_bytes = sizeof h;
+		h.n = recs.size();
+		h.rows = rows;
+		memcpy(h.updates, upd, sizeof h.updates);
+		FILE *out = fopen(fn,"wb");
+		if (!out){ fprintf(stderr,"Cannot write %s\n",fn); return; }
+		if (fwrite(&h, sizeof h, 1, out) != 1 || fwrite(recs.data(), sizeof(QueryTraceRecord), recs.size(), out) != recs.size())
+			fprintf(stderr,"Error writing %s\n",fn);
+		fclose(out);
+	}
+};
+
+class QueryTraceReader { public:
+	QueryTraceHeader header;
+	const QueryTraceRecord *records;
+	long long n;
+
+	QueryTraceReader(): records(0), n(0), map(0), map_bytes(0) {}
+	~QueryTraceReader(){ if (map) munmap(map, map_bytes); }
+
+	// maps the trace, exits with a message on failure
+	void open(const char *fn){
+		int fd = ::open(fn, O_RDONLY);
+		if (fd < 0){ fprintf(stderr,"Error opening trace %s\n",fn); exit(1); }
+		struct stat st;
+		if (fstat(fd, &st) != 0){ perror("fstat"); exit(1); }
+		map_bytes = st.st_size;
+		if (map_bytes < sizeof header){ fprintf(stderr,"%s is not a query trace\n",fn); exit(1); }
+
+		void *p = mmap(0, map_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED){ perror("mmap"); fprintf(stderr,"Error mapping %s!\n",fn); exit(1); }
+		map = (char*) p;
+		madvise(map, map_bytes, MADV_SEQUENTIAL);
+
+		memcpy(&header, map, sizeof header);
+		if (memcmp(header.magic, "SCRKQTR1", 8) || header.record_bytes != sizeof(QueryTraceRecord) ||
+				header.header_bytes < (int) sizeof header ||
+				header.header_bytes + header.n * header.record_bytes > (long long) map_bytes){
+			fprintf(stderr,"%s is not a query trace or is truncated\n",fn);
+			exit(1);
+		}
+		header.updates[sizeof header.updates - 1] = 0;
+		records = (const QueryTraceRecord*) (map + header.header_bytes);
+		n = header.n;
+	}
+
+private:
+	char *map;
+	size_t map_bytes;
+};
+
+// Pacing of a replay, from SCRACK_REPLAY_SPEED: 0 (the default) issues
+// everything back to back, 1 at the recorded times, k k times faster.
+struct ReplayClock {
+	double speed;
+	std::chrono::steady_clock::time_point t0;
+
+	ReplayClock(){
+		const char *env = getenv("SCRACK_REPLAY_SPEED");
+		speed = env ? atof(env) : 0;
+		restart();
+	}
+	void restart(){ t0 = std::chrono::steady_clock::now(); }
+	// sleeps until t seconds of the recording have passed
+	void wait(double t){
+		if (speed > 0)
+			std::this_thread::sleep_until(t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>(t / speed)));
+	}
+};
+
+#endif
@@ -13,6 +13,18 @@ public:
 	Random(){ setSeed(140384); }
 	Random(long long s){ setSeed(s); }
 	void setSeed(long long s){ seed = (s ^ multiplier) & mask; }
+
+	// advances the sequence as if next() were called n times, in O(log n),
+	// so a sequence can be generated in parallel from several offsets
+	void skip(unsigned long long n){
+		unsigned long long m = multiplier, a = addend, M = 1, A = 0;	// x -> M x + A
+		for (; n; n >>= 1){
+			if (n & 1){ M = M * m & mask; A = (A * m + a) & mask; }
+			a = (m + 1) * a & mask;		// x -> m x + a, squared
+			m = m * m & mask;
+		}
+		seed = (seed * M + A) & mask;
+	}
 	int next(int bits) {
 		seed = (seed * multiplier + addend) & mask;
 		return (int)(seed >> (48 - bits));
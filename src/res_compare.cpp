@@ -0,0 +1,228 @@
+// Compares two result sets of per-query metrics (res/*.mtr) and exits
+// non-zero on a statistically significant regression, so engine changes can
+// be gated on it.
+//
+// usage: res_compare [-c column] [-n resamples] [-a alpha] [-t threshold%] [-f factor] BASELINE NEW
+//
+// BASELINE and NEW are comma separated lists of metrics files or directories
+// of them. Experiments are matched by file name; an experiment found more
+// than once on a side (the same name in several result directories) has
+// that many repetitions. For each experiment, on the column (default
+// total_t), it compares
+//
+//   cumulative    the sum over all queries
+//   first         the first query's cost (it includes the initialization)
+//   converged     the number of queries after which the moving average of
+//                 max(1, Q/100) queries never again exceeds factor (default
+//                 2) times the steady state, the mean of the last 10%
+//
+// each with the ratio NEW/BASELINE and a bootstrap confidence interval
+// (1 - alpha, default 95%). A resample picks one of the repetitions and
+// resamples its queries within consecutive blocks of max(1, Q/100), which
+// keeps the convergence trend and varies the per-query noise. The first
+// query can only vary across repetitions, so it is tested when both sides
+// have at least three. A metric regressed when the whole interval is above
+// 1 + threshold (default 0%).
+//
+// Exit status: 0 no regression, 1 regression, 2 usage or input errors.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "metrics.h"
+#include "random.h"
+
+using namespace std;
+
+#define REP(i,n) for (int i=0,_n=n; i<_n; i++)
+
+typedef vector<vector<double> > Runs;	// an experiment's repetitions
+
+const char *column = "total_t";
+int resamples = 2000;
+double alpha = 0.05, threshold = 0, factor = 2;
+
+int block_size(int n){ return max(1, n / 100); }
+
+double cumulative(const vector<double> &x){
+	double s = 0;
+	REP(i,x.size()) s += x[i];
+	return s;
+}
+
+double first(const vector<double> &x){ return x[0]; }
+
+double converged(const vector<double> &x){
+	int n = x.size(), w = block_size(n), tail = max(1, n / 10);
+	vector<double> pre(n + 1, 0);
+	REP(i,n) pre[i+1] = pre[i] + x[i];
+	double steady = (pre[n] - pre[n-tail]) / tail;
+	for (int j=n-w; j>=0; j--)
+		if (pre[j+w] - pre[j] > factor * steady * w) return j + w;
+	return 0;
+}
+
+struct Metric {
+	const char *name;
+	double (*f)(const vector<double> &);
+	int min_reps;	// repetitions needed per side for an interval
+} METRICS[] = {
+	{ "cumulative", cumulative, 1 },
+	{ "first", first, 3 },
+	{ "converged", converged, 1 },
+};
+const int NMETRICS = sizeof(METRICS) / sizeof(METRICS[0]);
+
+void resample(const Runs &runs, Random &r, vector<double> &out){
+	const vector<double> &x = runs[r.nextInt(runs.size())];
+	int n = out.size(), b = block_size(n);
+	out[0] = x[0];	// the first query is unlike any other
+	for (int i=1; i<n; i+=b){
+		int e = min(n, i + b);
+		for (int j=i; j<e; j++) out[j] = x[i + r.nextInt(e - i)];
+	}
+}
+
+bool is_dir(const string &path){
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// the column of every metrics file of the list, by file name
+bool load(const char *list, map<string, Runs> &out){
+	string s = list;
+	vector<string> files;
+	for (size_t i=0, j; i<s.size(); i=j+1){
+		j = s.find(',', i);
+		if (j == string::npos) j = s.size();
+		string path = s.substr(i, j-i);
+		if (path.empty()) continue;
+		if (!is_dir(path)){ files.push_back(path); continue; }
+		// directories also hold throughput and stream files: only the
+		// metrics files with the column
+		DIR *d = opendir(path.c_str());
+		if (!d){ fprintf(stderr,"Cannot open %s\n",path.c_str()); return false; }
+		vector<string> names;
+		for (struct dirent *e; (e = readdir(d)); ){
+			string name = e->d_name;
+			if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".mtr")) continue;
+			vector<double> none;
+			vector<string> columns;
+			read_metrics_column((path + "/" + name).c_str(), "", none, NULL, &columns);
+			if (find(columns.begin(), columns.end(), column) != columns.end()) names.push_back(name);
+		}
+		closedir(d);
+		sort(names.begin(), names.end());
+		REP(k,names.size()) files.push_back(path + "/" + names[k]);
+	}
+	REP(k,files.size()){
+		vector<double> values;
+		if (!read_metrics_column(files[k].c_str(), column, values)) return false;
+		if (values.empty()) continue;
+		out[files[k].substr(files[k].rfind('/') + 1)].push_back(values);
+	}
+	return true;
+}
+
+// repetitions cut to the shortest run of either side (time limits), so both
+// sides are compared over the same queries
+int common_length(Runs &base, Runs &cand){
+	size_t n = base[0].size();
+	REP(i,base.size()) n = min(n, base[i].size());
+	REP(i,cand.size()) n = min(n, cand[i].size());
+	REP(i,base.size()) base[i].resize(n);
+	REP(i,cand.size()) cand[i].resize(n);
+	return n;
+}
+
+double mean_of(const Runs &runs, double (*f)(const vector<double> &)){
+	double s = 0;
+	REP(i,runs.size()) s += f(runs[i]);
+	return s / runs.size();
+}
+
+// the ratio's bootstrap interval; ratios of 0/0 count as 1
+void interval(const Runs &base, const Runs &cand, double (*f)(const vector<double> &), Random &r,
+		double &lo, double &hi){
+	int n = base[0].size();
+	vector<double> xb(n), xc(n), ratios(resamples);
+	REP(k,resamples){
+		resample(base, r, xb);
+		resample(cand, r, xc);
+		double b = f(xb), c = f(xc);
+		ratios[k] = b > 0 ? c / b : (c > 0 ? 1e300 : 1);
+	}
+	sort(ratios.begin(), ratios.end());
+	lo = ratios[min(resamples - 1, (int) (alpha / 2 * resamples))];
+	hi = ratios[min(resamples - 1, (int) ((1 - alpha / 2) * resamples))];
+}
+
+int main(int argc, char *argv[]){
+	int npos = 0;
+	const char *sides[2] = { NULL, NULL };
+	for (int i=1; i<argc; i++){
+		if (!strcmp(argv[i],"-c") && i+1 < argc) column = argv[++i];
+		else if (!strcmp(argv[i],"-n") && i+1 < argc) resamples = max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i],"-a") && i+1 < argc) alpha = atof(argv[++i]);
+		else if (!strcmp(argv[i],"-t") && i+1 < argc) threshold = atof(argv[++i]) / 100;
+		else if (!strcmp(argv[i],"-f") && i+1 < argc) factor = atof(argv[++i]);
+		else if (npos < 2) sides[npos++] = argv[i];
+		else npos = 3;
+	}
+	if (npos != 2 || alpha <= 0 || alpha >= 1){
+		fprintf(stderr,"usage: %s [-c column] [-n resamples] [-a alpha] [-t threshold%%] [-f factor] BASELINE NEW\n", argv[0]);
+		fprintf(stderr,"BASELINE and NEW are comma separated lists of metrics files or directories of them\n");
+		return 2;
+	}
+
+	map<string, Runs> base, cand;
+	if (!load(sides[0], base) || !load(sides[1], cand)) return 2;
+	bool single = base.size() == 1 && cand.size() == 1;	// two files: compare them whatever their names
+	if (single && base.begin()->first != cand.begin()->first){
+		Runs runs = cand.begin()->second;
+		cand.clear();
+		cand[base.begin()->first] = runs;
+	}
+
+	Random r(160284);
+	int regressions = 0, compared = 0;
+	printf("%-40s %-10s %5s %12s %12s %7s  %-17s\n", "experiment", "metric", "reps", "baseline", "new", "ratio",
+		"CI");
+	for (map<string, Runs>::iterator it = base.begin(); it != base.end(); ++it){
+		if (!cand.count(it->first)){ printf("%-40s (not in NEW)\n", it->first.c_str()); continue; }
+		Runs &b = it->second, &c = cand[it->first];
+		int n = common_length(b, c);
+		compared++;
+		REP(m,NMETRICS){
+			const Metric &M = METRICS[m];
+			double mb = mean_of(b, M.f), mc = mean_of(c, M.f);
+			double ratio = mb > 0 ? mc / mb : (mc > 0 ? 1e300 : 1);
+			printf("%-40s %-10s %2d/%-2d %12.6g %12.6g %7.3lf  ", m ? "" : it->first.c_str(), M.name,
+				(int) b.size(), (int) c.size(), mb, mc, ratio);
+			if (int(b.size()) < M.min_reps || int(c.size()) < M.min_reps){
+				printf("(needs %d repetitions)\n", M.min_reps);
+				continue;
+			}
+			double lo, hi;
+			interval(b, c, M.f, r, lo, hi);
+			printf("[%6.3lf, %6.3lf]", lo, hi);
+			if (lo > 1 + threshold){ printf(" REGRESSION"); regressions++; }
+			else if (hi < 1 - threshold) printf(" improved");
+			printf("\n");
+		}
+		if (n < 2) printf("%-40s (%d queries)\n", "", n);
+	}
+	for (map<string, Runs>::iterator it = cand.begin(); it != cand.end(); ++it)
+		if (!base.count(it->first)) printf("%-40s (not in BASELINE)\n", it->first.c_str());
+
+	if (!compared){ fprintf(stderr,"No experiment is in both result sets\n"); return 2; }
+	printf("%d regression%s in %d experiment%s (column %s, %.0lf%% intervals, threshold %.1lf%%)\n", regressions,
+		regressions == 1 ? "" : "s", compared, compared == 1 ? "" : "s", column, (1 - alpha) * 100, threshold * 100);
+	return regressions ? 1 : 0;
+}
@@ -4,11 +4,36 @@
 #include <math.h>
 #include <vector>
 #include <algorithm>
+#include "metrics.h"
 
 using namespace std;
 
+// prints one column of a metrics file the way the per-metric text files
+// had it, one value per line (without a column, lists the columns)
+int dump(const char *fn, const char *column){
+	vector<double> values;
+	vector<string> names;
+	int type = 0;
+	if (!read_metrics_column(fn, column, values, &type, &names)){
+		if (column[0]) return 1;
+		for (int i=0; i<int(names.size()); i++) printf("%s\n", names[i].c_str());
+		return 0;
+	}
+	for (int i=0; i<int(values.size()); i++){
+		if (type) printf("%.6lf\n", values[i]);
+		else printf("%.0lf\n", values[i]);
+	}
+	return 0;
+}
+
 int main(int argc, char *argv[]){
-	if (argc < 5){ fprintf(stderr,"usage: %s [nqueries] [npoints] [is_cumulative] [is_float]\n", argv[0]); exit(1); }
+	if (argc >= 3 && !strcmp(argv[1],"dump")) return dump(argv[2], argc > 3 ? argv[3] : "");
+	if (argc < 5 || argc == 6){
+		fprintf(stderr,"usage: %s [nqueries] [npoints] [is_cumulative] [is_float] [metrics-file column]\n", argv[0]);
+		fprintf(stderr,"       %s dump [metrics-file] [column]\n", argv[0]);
+		fprintf(stderr,"values are read from stdin, one per line, unless a metrics file and column are given\n");
+		exit(1);
+	}
 
 	int Q = atoi(argv[1]), 
 		nPoints = atoi(argv[2]),
@@ -20,13 +45,20 @@ int main(int argc, char *argv[]){
 		linGap = (double) Q/nPoints,
 		value = 0, cvalue = 0;
 
-	vector<double> values;
+	vector<double> values, column;
 	vector<int> xs;
+	bool from_file = argc > 6;
+	if (from_file && !read_metrics_column(argv[5], argv[6], column)) exit(1);
 
 	for (int i=1; i<=Q; i++){
-		int nr = scanf("%lf",&value);
-//		fprintf(stderr, "val %lf\n", value);
-		assert(nr == 1);
+		if (from_file){
+			assert(i <= int(column.size()));
+			value = column[i-1];
+		} else {
+			int nr = scanf("%lf",&value);
+//			fprintf(stderr, "val %lf\n", value);
+			assert(nr == 1);
+		}
 		cvalue += value;
 		if (i >= nextSample || i == Q){
 			xs.push_back(i);
@@ -1,39 +1,44 @@
-#include "tester.h"           // require implementations of init,insert,remove,query
+#include "tester.h"           // the Algorithm interface
 
-int *arr, allocN, N;          // the dataset array
-int *marr, msize;
+// Scans the whole column for every query
+class Scan : public Algorithm { public:
+  int *arr, allocN, N;          // the dataset array
+  int *marr, msize;
 
-void init(int *a, int n, int cap){
-  marr = new int[n];
-  arr = new int[allocN = N = n];    // for updates expansion
-  for (int i=0; i<N; i++)
-    arr[i] = a[i];           // copy all
-}
+  Scan(): arr(0), marr(0) {}
+  ~Scan(){ delete[] arr; delete[] marr; }
 
-void insert(int v){
-  assert(N < allocN);
-  arr[N++] = v;
-}
+  void init(int *a, int n, int cap){
+    marr = new int[n];
+    arr = new int[allocN = N = n];    // for updates expansion
+    for (int i=0; i<N; i++)
+      arr[i] = a[i];           // copy all
+  }
 
-void remove(int v){
-  for (int i=0; i<N; i++)
-    if (arr[i] == v){
-      arr[i] = arr[--N];
-      return;
-    }
-  assert(0);
-}
+  void insert(int v){
+    assert(N < allocN);
+    arr[N++] = v;
+  }
 
-int view_query(int a, int b){
-  msize = 0;
-  for (int i=0; i<N; i++) 
-    if (arr[i] >= a && arr[i] < b)
-      marr[msize++] = arr[i];
-  n_touched += N;
-  return msize;      // returns 1 means all results are fully materialized
-}
+  void remove(int v){
+    for (int i=0; i<N; i++)
+      if (arr[i] == v){
+        arr[i] = arr[--N];
+        return;
+      }
+    assert(0);
+  }
 
-int count_query(int a, int b){
-  return view_query(a,b);
-}
+  int view_query(int a, int b){
+    msize = 0;
+    for (int i=0; i<N; i++)
+      if (arr[i] >= a && arr[i] < b)
+        marr[msize++] = arr[i];
+    n_touched += N;
+    return msize;      // returns 1 means all results are fully materialized
+  }
 
+  int count_query(int a, int b){
+    return view_query(a,b);
+  }
+};
@@ -1,20 +1,25 @@
 #include "crack.h"
 
-Random rr;
+// Selective stochastic cracking: a random crack with materialization instead
+// of the standard crack on every DETERMINISTIC-th query, or with probability
+// PROBABILISTIC/100 (0 = off)
+template <int DETERMINISTIC, int PROBABILISTIC>
+class Selective : public Cracker { public:
+  Random rr;
+  int nth;
 
-int view_query(int a, int b){
-  #ifdef DETERMINISTIC
-    static int nth = 0;
-    int cnt = (++nth % DETERMINISTIC == 0)? random_crack_and_materialize(a,b) : crack(a,b);
-  #endif
+  Selective(): nth(0) {}
 
-  #ifdef PROBABILISTIC
-    int cnt = (rr.nextDouble() < PROBABILISTIC)? random_crack_and_materialize(a,b) : crack(a,b);
-  #endif
+  int view_query(int a, int b){
+    int cnt;
+    if (DETERMINISTIC)
+      cnt = (++nth % DETERMINISTIC == 0)? random_crack_and_materialize(a,b) : crack(a,b);
+    else
+      cnt = (rr.nextDouble() < PROBABILISTIC / 100.0)? random_crack_and_materialize(a,b) : crack(a,b);
+    return cnt;
+  }
 
-  return cnt;
-}
-
-int count_query(int a, int b){
-  return view_query(a,b);
-}
+  int count_query(int a, int b){
+    return view_query(a,b);
+  }
+};
@@ -1,18 +1,54 @@
+#ifndef _SCRACK_TESTER_H_
+#define _SCRACK_TESTER_H_
+
 #include <stdio.h>
 #include <stdarg.h>
 #include <assert.h>
 #include <sys/time.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
 #include "workload.h"
-#include <zlib.h>
+#include "metrics.h"
+#include "perf_counters.h"
+#include "data_file.h"
+
+// An indexing algorithm under test. Implementations take their tuning
+// parameters as template arguments, so each configuration is compiled with
+// its constants folded in, and bench.cpp picks one at runtime.
+struct Algorithm {
+	virtual ~Algorithm(){}
+	virtual void init(int *a, int n, int cap) = 0;	// copies the first n of a, room for cap
+	virtual void insert(int v) = 0;
+	virtual void remove(int v) = 0;
+	virtual int view_query(int a, int b) = 0;	// returns a view
+	virtual int count_query(int a, int b) = 0;
+};
 
-void init(int *a, int n, int cap);
-void insert(int v);
-void remove(int v);
-int view_query(int a, int b);	// returns a view
-int count_query(int a, int b);
+// SCRACK_RECORD=FILE in the environment records every query and update the
+// algorithm receives, with their times, to a query trace (query_trace.h);
+// the query workload trace:FILE replays it. Concurrent streams are recorded
+// in the order the engine served them, so their replay is one stream.
+struct RecordingAlgorithm : Algorithm {
+	Algorithm &A;
+	QueryTraceWriter T;
+
+	RecordingAlgorithm(Algorithm &A, const char *fn, const char *updates): A(A), T(fn, updates) {}
+	void init(int *a, int n, int cap){ A.init(a, n, cap); T.restart(n); }
+	void insert(int v){ T.add(QT_INSERT, v); A.insert(v); }
+	void remove(int v){ T.add(QT_DELETE, v); A.remove(v); }
+	int view_query(int a, int b){ T.add(QT_VIEW, a, b); return A.view_query(a, b); }
+	int count_query(int a, int b){ T.add(QT_COUNT, a, b); return A.count_query(a, b); }
+};
 
 int N1,N2,N3,N4,N5,N6,QQQ,n_cracks,n_trash,n_rippled,n_touched;
 
+// Heap allocations on any thread of the process, counted by bench.cpp's
+// operator new; a query's n_allocs is the difference across it.
+extern std::atomic<long long> heap_allocs;
+
 struct Timer {
 	struct timeval tv0, tv1;
 	double total;
@@ -30,92 +66,211 @@ double timing(){
 	return ret;
 }
 
-// class GzWriter { public:
-// 	FILE *f;
-// 	GzWriter(const char *const fn){
-// 		f = fopen(fn,"wb");
-// 		if (!f){
-// 			fprintf(stderr, "fopen of '%s' failed:.\n", fn);
-// 			exit(EXIT_FAILURE);
-// 		}
-// 	}
-// 	~GzWriter(){ fclose(f); }
-// 	void printf(const char *fmt, ...){
-// 		va_list argptr;
-// 		va_start(argptr,fmt);
-// 		fprintf(f, fmt, argptr);
-// 		va_end(argptr);
-// 	}
-// };
-
-class GzWriter { public:
-	gzFile f;
-	GzWriter(const char *const fn){
-		f = gzopen(fn,"wb");
-		if (!f){
-			fprintf(stderr, "gzopen of '%s' failed:.\n", fn);
-			exit(EXIT_FAILURE);
+// Optional hardware counters (SCRACK_PERF=1 in the environment): per query,
+// the update and search phases' counts are recorded as update_<counter> and
+// search_<counter> columns next to the timings, for whichever counters the
+// machine provides. Counters are per thread, so each query stream has its own.
+struct PhaseCounters {
+	PerfCounters pc;
+	double *update[PerfCounters::NCOUNTERS], *search[PerfCounters::NCOUNTERS];
+	bool on;
+
+	PhaseCounters(MetricsRecorder &M, bool report){
+		const char *env = getenv("SCRACK_PERF");
+		on = env && atoi(env) && pc.open();
+		if (env && atoi(env) && !on && report)
+			fprintf(stderr,"(hardware counters unavailable, not recorded) ");
+		for (int c=0; c<PerfCounters::NCOUNTERS; c++){
+			update[c] = search[c] = NULL;
+			if (!on || !pc.available(c)) continue;
+			string name = PerfCounters::name(c);
+			update[c] = M.doubles(("update_" + name).c_str());
+			search[c] = M.doubles(("search_" + name).c_str());
 		}
 	}
-	~GzWriter(){ gzclose(f); }
-	void printf(const char *fmt, ...){
-		static char s[10000];
-		va_list argptr;
-		va_start(argptr,fmt);
-		int ns = vsprintf(s, fmt, argptr);
-		va_end(argptr);
-
-		assert(ns > 0);
-		int w = gzwrite(f,s,ns);
-		if (w == 0){
-			int err_no = 0;
-			fprintf(stderr, "Error during compression: %s", gzerror(f, &err_no));
-			gzclose(f);
-			exit(err_no);
-		}
+	void start(){ if (on){ pc.clear(); pc.start(); } }
+	void stop(double **column, int i){
+		if (!on) return;
+		pc.stop();
+		for (int c=0; c<PerfCounters::NCOUNTERS; c++) if (column[c]) column[c][i] = pc.value(c);
 	}
 };
 
-// ./a.out input-data num-of-queries query-workload update-workload time-limit
-int main(int argc, char *argv[]){
-	if (argc < 7){
-		fprintf(stderr,"usage: ./a.out [input-file] [num of queries] [selectivity] [query workload] [update workload] [time limit] [output-file]\n");
-		exit(1);
+// Concurrent mode: `streams` threads each run Q queries from their own
+// Workload (seeded 29284 + stream, so stream 0 sees the single-stream
+// query sequence) against the one shared engine. Engine calls are
+// serialized by a mutex unless the engine defines TESTER_THREAD_SAFE before
+// including this file; the time spent waiting for it is part of a query's
+// latency and is also recorded on its own. Replacement updates (LFHV, HFLV)
+// and deletes (DELETE) are issued by stream 0 on the single-stream schedule.
+//
+// Per stream, res/stream<k>.mtr has the columns total_t, search_t, wait_t,
+// update_t, done_at (seconds since the start) and result_size, one row per
+// query; res/throughput.mtr has the number of queries completed across all
+// streams in each 100ms interval.
+std::mutex engine_mutex;
+
+struct StreamMetrics {
+	MetricsRecorder M;
+	double *total_t, *search_t, *wait_t, *update_t, *done_at;
+	int *result_size;
+	StreamMetrics(const char *fn, int Q): M(fn, Q) {
+		total_t = M.doubles("total_t");
+		search_t = M.doubles("search_t");
+		wait_t = M.doubles("wait_t");
+		update_t = M.doubles("update_t");
+		done_at = M.doubles("done_at");
+		result_size = M.ints("result_size");
 	}
+};
+
+int run_streams(Algorithm &A, int streams, int *arr, int &N, int mx, char *workload, int S, int Q, int K1, int K2,
+		int Qret, double init_t, int TLE){
+	vector<StreamMetrics*> out(streams);
+	for (int s=0; s<streams; s++){
+		char fn[100];
+		sprintf(fn,"res/stream%d.mtr",s);
+		out[s] = new StreamMetrics(fn, Q);
+	}
+	vector<std::thread> threads;
+	double wall = 0;
+	struct timeval t0;
+	gettimeofday(&t0,NULL);
+	auto now = [&t0](){
+		struct timeval t; gettimeofday(&t,NULL);
+		return t.tv_sec - t0.tv_sec + (t.tv_usec - t0.tv_usec) * 1e-6;
+	};
+
+	for (int s=0; s<streams; s++) threads.emplace_back([&, s](){
+		Workload W(mx, workload, S, 29284 + s);
+		Random r(160284);
+		StreamMetrics &o = *out[s];
+		PhaseCounters P(o.M, s == 0);
+		for (int a,b,i=0,res; i<Q; i++){
+			if (init_t + now() > TLE){ if (s == 0) fprintf(stderr,"X"); break; }
+			if (s == 0 && !(i&(i+1))) fprintf(stderr,".");
+			if (!W.query(a,b)) break;
+
+			double update_t = 0;
+			if (s == 0 && (i+1) % K1 == 0 && K2 != 0){
+				std::unique_lock<std::mutex> lock(engine_mutex, std::defer_lock);
+#ifndef TESTER_THREAD_SAFE
+				lock.lock();
+#endif
+				P.start();
+				double u0 = now();
+				if (K2 == -100000){
+					for (int j=0; j<1000; j++){
+						int idx = r.nextInt(N);
+						A.remove(arr[idx]);
+						arr[idx] = arr[--N];
+					}
+				} else {
+					for (int j=0; j<K2; j++){
+						int idx = r.nextInt(N), val = abs(r.nextInt());
+						A.remove(arr[idx]);
+						A.insert(val);
+						arr[idx] = val;
+					}
+				}
+				update_t = now() - u0;
+				P.stop(P.update, i);
+			}
+
+			double q0 = now();
+			std::unique_lock<std::mutex> lock(engine_mutex, std::defer_lock);
+#ifndef TESTER_THREAD_SAFE
+			lock.lock();
+#endif
+			P.start();
+			double q1 = now();
+			res = Qret ? A.count_query(a,b) : A.view_query(a,b);
+			double q2 = now();
+			P.stop(P.search, i);
+			if (lock.owns_lock()) lock.unlock();
 
-	int MAXN = 600000000;
-	int *arr = new int[MAXN], TLE, Q, K1, K2, ROLLV=1010000000;
-	if (!arr){ fprintf(stderr,"Cannot allocate %d integers\n", MAXN); exit(1); }
-	FILE *in = fopen(argv[1],"rb");
-	if (!in){ fprintf(stderr,"Error opening file %s\n",argv[1]); exit(1); }
-	sscanf(argv[2],"%d",&Q);
+			o.wait_t[i] = q1 - q0;
+			o.search_t[i] = q2 - q1;
+			o.update_t[i] = update_t;
+			o.total_t[i] = update_t + q2 - q0;
+			o.result_size[i] = res;
+			o.done_at[i] = q2;
+			o.M.next();
+		}
+	});
+	for (auto &t : threads) t.join();
+	wall = now();
+
+	// files are written after the run so the streams never wait on I/O
 	int total = 0;
-	int* arrpos = arr;
-	while (int sumtot = fread(arrpos, sizeof(int), 1000, in)) {
-		total += sumtot;
-		arrpos += sumtot;
+	vector<int> per_interval(int(wall * 10) + 1, 0);
+	for (int s=0; s<streams; s++){
+		for (int i=0; i<out[s]->M.size(); i++) per_interval[int(out[s]->done_at[i] * 10)]++;
+		total += out[s]->M.size();
+		delete out[s];
+	}
+	MetricsRecorder T("res/throughput.mtr", per_interval.size());
+	int *queries = T.ints("queries");
+	for (int i=0; i<int(per_interval.size()); i++){ queries[i] = per_interval[i]; T.next(); }
+
+	fprintf(stderr," T=%9.6lf Q=%d K=%d qps=%.1lf\n", init_t + wall, total, streams, total / wall);
+	return total;
+}
+
+// Runs one experiment: Q queries of the query workload at the given
+// selectivity (a fraction of the domain) interleaved with the update
+// workload, answered as views or counts, within TLE seconds. Per-query
+// metrics go to metrics_fn (concurrent streams write res/stream<k>.mtr).
+// The harness modifies input.data (updates, ROLL, DELETE), so callers
+// running several experiments restore it in between. Returns the number of
+// queries run.
+//
+// A trace:FILE query workload replays the trace's queries, as views or
+// counts as recorded, and its updates just before the query that followed
+// them, so the update workload must be NOUP. SCRACK_REPLAY_SPEED paces the
+// replay (query_trace.h).
+int run_experiment(Algorithm &algorithm, const char *name, DataFile &input, int Q, const char *selectivity,
+		char *workload, char *updatew, char *returning, int TLE, int streams, const char *metrics_fn){
+	if (streams > 1 && strcmp(updatew,"NOUP") && strcmp(updatew,"LFHV") && strcmp(updatew,"HFLV") && strcmp(updatew,"DELETE")){
+		fprintf(stderr,"Update workload \"%s\" is not supported with concurrent query streams\n",updatew);
+		exit(1);
 	}
-	int N = total;
+	srand(1);	// every experiment sees the rand() sequence of a fresh process
+
+	const char *record = getenv("SCRACK_RECORD");
+	std::unique_ptr<RecordingAlgorithm> recorder(record && *record ? new RecordingAlgorithm(algorithm, record, updatew) : NULL);
+	Algorithm &A = recorder ? *recorder : algorithm;
+
+	int K1, K2, ROLLV=1010000000;
+	int *arr = input.data;
+	int N = input.n;
 	int cap = N*2+100;
-	if (ferror(in)){ perror("Error while reading file"); fprintf(stderr,"Error reading %s!\n", argv[1]); exit(1); }
-	if (!feof(in)){ fprintf(stderr,"Allocated array not enough! (read = %d)\n",N); exit(1); }
-	fclose(in);
 	int mx = *max_element(arr, arr+N), Qret = 0;
-	fprintf(stderr,"%15s %15s %5s S=%-8.0lf N=%-9d(%10d) I=",argv[0],argv[4],argv[5],atof(argv[3])*mx,N,mx);
+	fprintf(stderr,"%15s %15s %5s S=%-8.0lf N=%-9d(%10d) I=",name,workload,updatew,atof(selectivity)*mx,N,mx);
 
-	Workload W(mx,argv[4],(int)(atof(argv[3])*mx));
-	char *updatew = argv[5], *returning = argv[6];
-	if (strcmp(updatew,"ROLL") == 0){
+	Workload W(mx,workload,(int)(atof(selectivity)*mx));
+	const QueryTraceReader *trace = W.recording();
+	const char *prepare = updatew;	// the data as the queries saw it
+	if (trace){
+		if (streams > 1 || strcmp(updatew,"NOUP")){
+			fprintf(stderr,"\nA trace replays its own updates in one stream: use NOUP and no query streams\n");
+			exit(1);
+		}
+		prepare = trace->header.updates;
+	}
+	if (strcmp(prepare,"ROLL") == 0){
 		for (int i=0; i<N; i++)
 			if (arr[i] <= ROLLV) arr[i] += ROLLV;
-	} else if (strcmp(updatew,"APPEND") == 0){
-		K1 = 1000, K2 = -1000;
+	} else if (strcmp(prepare,"APPEND") == 0){
+		if (!trace) K1 = 1000, K2 = -1000;
 		assert(N >= 500000000);
 		N = 10000000;
 	}
+	if (trace && trace->header.rows != N)
+		fprintf(stderr,"(trace recorded on %lld rows) ",(long long) trace->header.rows);
 
 	timing();
-	init(arr, N, cap);
+	A.init(arr, N, cap);
 	double total_t = timing();
 	fprintf(stderr,"%.3lf ",total_t);
 
@@ -132,23 +287,27 @@ int main(int argc, char *argv[]){
 	else if (strcmp(returning,"count") == 0) Qret = 1;
 	fprintf(stderr, "%c", Qret?'C':'V');
 
-	sscanf(argv[7],"%d",&TLE);
-
+	if (streams > 1)
+		return run_streams(A, streams, arr, N, mx, workload, (int)(atof(selectivity)*mx), Q, K1, K2, Qret, total_t, TLE);
 
 	Random r(160284);
-	GzWriter result_size_f("res/result_size.gz");
-	GzWriter examined_f("res/examined.gz");
-	GzWriter n_cracks_f("res/n_cracks.gz");
-	GzWriter n_touched_f("res/n_touched.gz");
-	GzWriter n_trash_f("res/n_trash.gz");
-	GzWriter n_rippled_f("res/n_rippled.gz");
-	GzWriter update_t_f("res/update_t.gz");
-	GzWriter mri_t_f("res/mri_t.gz");
-	GzWriter mrd_t_f("res/mrd_t.gz");
-	GzWriter crack_t_f("res/crack_t.gz");
-	GzWriter tree_t_f("res/tree_t.gz");
-	GzWriter search_t_f("res/search_t.gz");
-	GzWriter total_t_f("res/total_t.gz");
+	MetricsRecorder M(metrics_fn, Q);
+	int *result_size_m = M.ints("result_size");
+	int *examined_m = M.ints("examined");
+	int *n_cracks_m = M.ints("n_cracks");
+	int *n_touched_m = M.ints("n_touched");
+	int *n_trash_m = M.ints("n_trash");
+	int *n_rippled_m = M.ints("n_rippled");
+	int *n_allocs_m = M.ints("n_allocs");
+	double *update_t_m = M.doubles("update_t");
+	double *mri_t_m = M.doubles("mri_t");
+	double *mrd_t_m = M.doubles("mrd_t");
+	double *crack_t_m = M.doubles("crack_t");
+	double *tree_t_m = M.doubles("tree_t");
+	double *search_t_m = M.doubles("search_t");
+	double *total_t_m = M.doubles("total_t");
+	PhaseCounters P(M, true);
+	ReplayClock pace;
 	for (int a,b,i=0,res, ROLL=N-1; i<Q; i++){
 		QQQ = i;
 		if (total_t > TLE){ fprintf(stderr,"X"); Q=i; break; }
@@ -163,26 +322,45 @@ int main(int argc, char *argv[]){
 		bool ok = W.query(a,b);	// get query endpoints based on the workload
 		if (!ok){ Q = i; break; }
 
+		if (trace){
+			int nu;
+			const QueryTraceRecord *u = W.updates(nu);
+			if (nu){
+				pace.wait(W.updates_at());
+				P.start();
+				for (int j=0; j<nu; j++){
+					timing();
+						if (u[j].kind == QT_INSERT) A.insert(u[j].a);
+						else A.remove(u[j].a);
+					update_t += timing();
+				}
+				P.stop(P.update, i);
+			}
+			pace.wait(W.issued_at());
+			Qret = W.query_kind() == QT_COUNT;
+		}
+
 		// do updates every K1 iteration
 		if ((i+1) % K1 == 0){
+			P.start();
 			if (K2 == -10000){	// TRASH update workload
 				// only insert once in the middle domain: 10000
 				for (int j=0; i==K1-1 && j<1000000; j++){
 					int val = abs(r.nextInt());
 					assert(val >=0 && val <= 2147483647);
 					timing();
-						insert(val);
+						A.insert(val);
 					update_t += timing();
 				}
 				fprintf(stderr, "H");
 				K1 *= 10000;
 				// K1 = Q+1;
 			} else if (K2 == -1000){
-				if (N < 580000000){
+				if (N < 580000000 && N + 10000000 <= (int)input.n){	// the rest of the file is the append source
 					// insert 10M tuples
 					timing();
 					for (int j=0; j<10000000; j++){
-						insert(arr[N++]);
+						A.insert(arr[N++]);
 					}
 					update_t += timing();
 					fprintf(stderr, "A");
@@ -191,7 +369,7 @@ int main(int argc, char *argv[]){
 				for (int j=0; j<1000; j++){
 					int idx = r.nextInt(N);
 					timing();
-						remove(arr[idx]);
+						A.remove(arr[idx]);
 					update_t += timing();
 					arr[idx] = arr[--N];
 				}
@@ -199,8 +377,8 @@ int main(int argc, char *argv[]){
 				// if ((i+1)%1000000 == 0) fprintf(stderr, "arr[%d] = %d, next = %d\n", ROLL,arr[ROLL],ROLLV);
 				for (int j=0; j>K2; j--){
 					timing();
-						remove(arr[ROLL]);
-						insert(ROLLV);
+						A.remove(arr[ROLL]);
+						A.insert(ROLLV);
 					update_t += timing();
 
 					arr[ROLL--] = ROLLV--;
@@ -213,13 +391,14 @@ int main(int argc, char *argv[]){
 				for (int j=0; j<K2; j++){
 					int idx = r.nextInt(N), val = abs(r.nextInt());
 					timing();
-						remove(arr[idx]);
-						insert(val);
+						A.remove(arr[idx]);
+						A.insert(val);
 					update_t += timing();
 					arr[idx] = val;
 				}
 			}
 			// fprintf(stderr, "y");
+			P.stop(P.update, i);
 		}
 		if (K2 == -10){
 			a = ROLLV;
@@ -227,28 +406,33 @@ int main(int argc, char *argv[]){
 		}
 
 		n_cracks = n_trash = n_rippled = n_touched = 0;
+		long long allocs = heap_allocs;
 
-		if (Qret == 0){ 		timing(); res = view_query(a,b); search_t = timing();
-		} else if (Qret == 1){	timing(); res = count_query(a,b); search_t = timing();
+		P.start();
+		if (Qret == 0){ 		timing(); res = A.view_query(a,b); search_t = timing();
+		} else if (Qret == 1){	timing(); res = A.count_query(a,b); search_t = timing();
 		} else { assert(0); }
+		P.stop(P.search, i);
 	
 		if (i==0) fprintf(stderr,"F=%.3lf ",search_t);
 
 		total_t += update_t + search_t;
 
-		result_size_f.printf("%d\n", res);
-		examined_f.printf("%d\n", n_trash+n_rippled+n_touched);
-		n_cracks_f.printf("%d\n", n_cracks);
-		n_touched_f.printf("%d\n", n_touched);
-		n_trash_f.printf("%d\n", n_trash);
-		n_rippled_f.printf("%d\n", n_rippled);
-		mri_t_f.printf("%.6lf\n", mri_t.elapsed());
-		mrd_t_f.printf("%.6lf\n", mrd_t.elapsed());
-		crack_t_f.printf("%.6lf\n", crack_t.elapsed());
-		tree_t_f.printf("%.6lf\n", tree_t.elapsed());
-		search_t_f.printf("%.6lf\n", search_t);
-		update_t_f.printf("%.6lf\n", update_t);
-		total_t_f.printf("%.6lf\n", update_t + search_t);
+		result_size_m[i] = res;
+		examined_m[i] = n_trash+n_rippled+n_touched;
+		n_cracks_m[i] = n_cracks;
+		n_touched_m[i] = n_touched;
+		n_trash_m[i] = n_trash;
+		n_rippled_m[i] = n_rippled;
+		n_allocs_m[i] = heap_allocs - allocs;
+		mri_t_m[i] = mri_t.elapsed();
+		mrd_t_m[i] = mrd_t.elapsed();
+		crack_t_m[i] = crack_t.elapsed();
+		tree_t_m[i] = tree_t.elapsed();
+		search_t_m[i] = search_t;
+		update_t_m[i] = update_t;
+		total_t_m[i] = update_t + search_t;
+		M.next();
 	}
 	fprintf(stderr," T=%9.6lf Q=%d\n",total_t,Q);
 	// fprintf(stderr,"N1 = %8d, T1 = %9.6lf, rat = %.6lf\n",N1,t1,N1/t1);
@@ -258,6 +442,7 @@ int main(int argc, char *argv[]){
 	// fprintf(stderr,"N5 = %8d, T5 = %9.6lf, rat = %.6lf\n",N5,t5,N5/t5);
 	// fprintf(stderr,"N6 = %8d, T6 = %9.6lf, rat = %.6lf\n",N6,t6,N6/t6);
 	// fprintf(stderr,"Total = %9.6lf\n",t1+t2+t3+t4+t5+t6);
-
-	FILE *QF = fopen("res/res_q","w"); fprintf(QF,"%d\n",Q); fclose(QF);
+	return Q;
 }
+
+#endif
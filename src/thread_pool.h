@@ -0,0 +1,99 @@
+#ifndef _SCRACK_THREAD_POOL_H_
+#define _SCRACK_THREAD_POOL_H_
+
+#include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads for the fork-join loops inside a query (adaptive merging's
+// extraction). run(n, f) calls f(i) for every i in [0, n), spread over the
+// workers and the calling thread, and returns when all calls are done. The
+// workers sleep between loops, so an idle pool costs nothing.
+//
+// shared() is sized by SCRACK_THREADS in the environment, else the hardware
+// concurrency; with one thread run() is a plain loop. One loop runs at a
+// time, and f must not call run() itself.
+class ThreadPool { public:
+  explicit ThreadPool(int threads): generation(0), stop(false) {
+    for (int t=1; t<threads; t++) workers.emplace_back([this]{ work(); });
+  }
+
+  ~ThreadPool(){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for (size_t t=0; t<workers.size(); t++) workers[t].join();
+  }
+
+  static ThreadPool &shared(){
+    static ThreadPool pool(default_threads());
+    return pool;
+  }
+
+  static int default_threads(){
+    const char *env = getenv("SCRACK_THREADS");
+    int t = env ? atoi(env) : (int) std::thread::hardware_concurrency();
+    return t > 0 ? t : 1;
+  }
+
+  int size() const { return workers.size() + 1; }
+
+  void run(int n, const std::function<void(int)> &f){
+    if (workers.empty() || n <= 1){
+      for (int i=0; i<n; i++) f(i);
+      return;
+    }
+    std::lock_guard<std::mutex> one_loop(running);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &f;
+      count = n;
+      next = 0;
+      busy = workers.size();
+      generation++;
+    }
+    wake.notify_all();
+    take_items();
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]{ return busy == 0; });
+    job = NULL;
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex, running;
+  std::condition_variable wake, done;
+  const std::function<void(int)> *job;
+  int count;
+  std::atomic<int> next;
+  int busy;              // workers still in the current loop
+  long long generation;  // loops started
+  bool stop;
+
+  void take_items(){
+    for (int i; (i = next.fetch_add(1)) < count; ) (*job)(i);
+  }
+
+  void work(){
+    long long seen = 0;
+    while (true){
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]{ return stop || generation != seen; });
+        if (stop) return;
+        seen = generation;
+      }
+      take_items();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--busy == 0) done.notify_one();
+    }
+  }
+};
+
+#endif
@@ -1,8 +1,12 @@
+#ifndef _SCRACK_WORKLOAD_H_
+#define _SCRACK_WORKLOAD_H_
+
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 #include <algorithm>
 #include "random.h"
+#include "query_trace.h"
 
 using namespace std;
 
@@ -14,17 +18,30 @@ class Workload {
   int a, b; // the last query range [a,b]
   Random r; // Pseudo Random Generator
 
+  // generator state carried between queries (reset when I == 0); members
+  // rather than statics so independent generators can run side by side
+  FILE *sky;            // skyserver_w's query file
+  int prevB;            // seq_no_over_w's previous upper bound
+  int R1000[1000];      // cons_rand_w's endpoint pool
+  int L, R;             // current range of the zoom workloads
+  int work, base;       // mixed_w's current workload and region
+  QueryTraceReader *trace;        // trace_w's recording
+  long long pos;                  // its next record
+  long long now_us, upd_us;       // time of the last query, of its first update
+  const QueryTraceRecord *upd;    // the updates before the last query
+  int nupd, kind;                 // how many, and the last query's QT_VIEW/QT_COUNT
+
   // based on the predefined queries from file
   bool skyserver_w(){
-    static FILE *in = NULL;
     if (I==0){
-      in = fopen("data/skyserver.queries","r");
-      if (!in) fprintf(stderr,"Fail loading file data/skyserver.queries\n");
+      if (sky) fclose(sky);
+      sky = fopen("data/skyserver.queries","r");
+      if (!sky) fprintf(stderr,"Fail loading file data/skyserver.queries\n");
     }
-    if (!in) return false;
+    if (!sky) return false;
     double x,y;
-    if (fscanf(in,"%lf %lf",&x,&y)==EOF){
-      if (in){ fclose(in); in = NULL; }
+    if (fscanf(sky,"%lf %lf",&x,&y)==EOF){
+      if (sky){ fclose(sky); sky = NULL; }
       return false;
     }
     a = int(y*1000000);
@@ -80,7 +97,7 @@ class Workload {
   
   // sequential with no overlap with the subsequent query ranges
   bool seq_no_over_w(){
-    static int prevB; if (!I) prevB = 0;
+    if (!I) prevB = 0;
     a = prevB + 10;
     if (a + 5 > N) return false;
     if (S == 0){
@@ -104,11 +121,10 @@ class Workload {
   // pick 1000 integers and produce range queries with endpoints 
   // using the 1000 picked integers
   bool cons_rand_w(){
-    static int R[1000];
-    if (!I) for (int i=0; i<1000; i++) R[i] = r.nextInt(N);
+    if (!I) for (int i=0; i<1000; i++) R1000[i] = r.nextInt(N);
     do {
-      a = R[r.nextInt(1000)];
-      b = R[r.nextInt(1000)];
+      a = R1000[r.nextInt(1000)];
+      b = R1000[r.nextInt(1000)];
     } while (a == b);
     if (a > b) swap(a,b);
     return true;
@@ -117,8 +133,8 @@ class Workload {
   // start at the [middle - 100500, middle + 100500), 
   // then zoom in by making the query range smaller by 100 on each query
   bool zoom_in_w(){
-    static int L; if (!I) L = N/3;
-    static int R; if (!I) R = 2*N/3;
+    if (!I) L = N/3;
+    if (!I) R = 2*N/3;
     if (L >= R || L<0 || R>N) return false;
     a = L; L += 100;  // make the range smaller
     b = R; R -= 100;
@@ -128,8 +144,8 @@ class Workload {
   // start at the [middle - 500, middle + 500),
   // then zoom out by making the query range larger by 100 each query
   bool zoom_out_w(){
-    static int L; if (!I) L = N/2 - 500;
-    static int R; if (!I) R = N/2 + 500;
+    if (!I) L = N/2 - 500;
+    if (!I) R = N/2 + 500;
     if (L<1 || R>N) return false;
     a = L; L -= 100;  // make the range bigger
     b = R; R += 100;
@@ -138,9 +154,9 @@ class Workload {
   
   // after zooming in on one region, move to next unexplored region to the right
   bool seq_zoom_in(){
-    static int L; if (!I) L = 1;
-    static int G = 100000;
-    static int R; if (!I) R = G;
+    const int G = 100000;
+    if (!I) L = 1;
+    if (!I) R = G;
     if (L >= R) L += G, R = L + G;
     if (R > N) return false;
     a = L; L += 100;
@@ -150,9 +166,9 @@ class Workload {
   
   // after zooming out on one ragion, move to the next unexplored region on the right
   bool seq_zoom_out(){
-    static int G = 100000;
-    static int L; if (!I) L = G/2+1000;
-    static int R; if (!I) R = L + 10;
+    const int G = 100000;
+    if (!I) L = G/2+1000;
+    if (!I) R = L + 10;
     if (R > L+G) L = R+G/2+1000, R = L+10;
     if (R > N) return false;
     a = L; L -= 100;
@@ -182,8 +198,8 @@ class Workload {
   // start at the [middle - 500, middle + 500),
   // then zoom out by making the query range larger by 100 each query
   bool zoom_out_alt_w(){
-    static int L; if (!I) L = N/2 - 500;
-    static int R; if (!I) R = N/2 + 500;
+    if (!I) L = N/2 - 500;
+    if (!I) R = N/2 + 500;
     if (L<1 || R>N) return false;
     if (I&1){
       a = L; 
@@ -200,8 +216,8 @@ class Workload {
   // start at the [middle - 500, middle + 500),
   // then zoom out by making the query range larger by 100 each query
   bool skew_zoom_out_alt_w(){
-    static int L; if (!I) L = N - 355000;
-    static int R; if (!I) R = N - 350000;
+    if (!I) L = N - 355000;
+    if (!I) R = N - 350000;
     if (L<1 || R>N) return false;
     if (I&1){
       b = R; 
@@ -216,15 +232,13 @@ class Workload {
   }
   
   bool periodic_w(){
-    static long long jump = 1000001;
+    const long long jump = 1000001;
     a = (I * jump) % N;
     b = a + 10;
     return true;
   }
 
   bool mixed_w(){
-    static int work = 0;
-    static int base = 0;
     if (I%1000 == 0){
       work = r.nextInt(15) + 1;
       base = r.nextInt(20);
@@ -247,9 +261,43 @@ class Workload {
     return true;
   }
 
+  // replays a query trace: each query, and the updates recorded since the
+  // previous one, for the caller to apply
+  bool trace_w(){
+    if (!I) pos = now_us = 0;
+    upd = trace->records + pos;
+    nupd = 0;
+    for (; pos < trace->n; pos++){
+      const QueryTraceRecord &q = trace->records[pos];
+      now_us += q.dt_us;
+      if (q.kind == QT_VIEW || q.kind == QT_COUNT){
+        a = q.a;
+        b = q.b;
+        kind = q.kind;
+        pos++;
+        return true;
+      }
+      if (!nupd++) upd_us = now_us;
+    }
+    return false;
+  }
+
 public : 
-  Workload(int nElem, char *workload, int selectivity):N(nElem),S(selectivity){
-    r = Random(29284);
+  Workload(int nElem, char *workload, int selectivity, long long seed = 29284):N(nElem),S(selectivity){
+    r = Random(seed);
+    sky = NULL;
+    prevB = L = R = work = base = 0;
+    trace = NULL;
+    upd = NULL;
+    pos = now_us = upd_us = nupd = kind = 0;
+
+    if (!strncmp(workload, "trace:", 6)){   // 17
+      W = 17;
+      I = 0;
+      trace = new QueryTraceReader;
+      trace->open(workload + 6);
+      return;
+    }
 
     const char *names[17] = {  // workload names
       "SkyServer",     // 0
@@ -278,6 +326,20 @@ public :
       exit(1);
     }
   }
+
+  ~Workload(){ if (sky) fclose(sky); delete trace; }
+  Workload(const Workload &) = delete;
+  Workload &operator=(const Workload &) = delete;
+
+  // "trace:FILE" workloads: the recording (NULL for generated workloads), the
+  // updates it made before the last query, that query's kind (QT_VIEW or
+  // QT_COUNT), and when the query and the first of those updates were issued,
+  // in seconds since the recording started
+  const QueryTraceReader *recording() const { return trace; }
+  const QueryTraceRecord *updates(int &n) const { n = nupd; return upd; }
+  int query_kind() const { return kind; }
+  double issued_at() const { return now_us * 1e-6; }
+  double updates_at() const { return upd_us * 1e-6; }
   
   bool query(int &na, int &nb){
     switch (W){
@@ -298,9 +360,12 @@ public :
       case 14 : if (!skew_zoom_out_alt_w()) return false; break;
       case 15 : if (!periodic_w()) return false; break;
       case 16 : if (!mixed_w()) return false; break;
+      case 17 : if (!trace_w()) return false; break;
       default : assert(0);
     }
     na = a; nb = b; I++;
     return true;
   }
 };
+
+#endif